@@ -32,7 +32,7 @@ static constexpr uint16_t kSubCmdSealed = 0x0020;
 static constexpr uint16_t kDesignCapacityMah = 4200;
 
 Bq27441::Bq27441(i2c_port_t port)
-    : port_(port)
+    : device_(port, kAddress, "bq27441", I2cPriority::BACKGROUND)
 {
 }
 
@@ -255,15 +255,7 @@ bool Bq27441::write_block_data(uint8_t class_id, uint8_t offset, uint8_t *data,
     // Writing to 0x40 + block_offset
     
     // Let's write just the modified bytes
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (kAddress << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, kRegBlockData + block_offset, true);
-    i2c_master_write(cmd, data, len, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(100));
-    i2c_cmd_link_delete(cmd);
-    if (ret != ESP_OK) return false;
+    if (device_.write(kRegBlockData + block_offset, data, len) != ESP_OK) return false;
 
     // 5. Update Checksum
     // Calculate new checksum
@@ -286,18 +278,7 @@ bool Bq27441::control_command(uint16_t subcommand)
 bool Bq27441::read_word(uint8_t reg, uint16_t *val)
 {
     uint8_t data[2];
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (kAddress << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (kAddress << 1) | I2C_MASTER_READ, true);
-    i2c_master_read(cmd, data, 2, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(100));
-    i2c_cmd_link_delete(cmd);
-
-    if (ret == ESP_OK) {
+    if (device_.read(reg, data, 2) == ESP_OK) {
         *val = (data[1] << 8) | data[0]; // Little Endian
         return true;
     }
@@ -310,33 +291,10 @@ bool Bq27441::write_word(uint8_t reg, uint16_t val)
     data[0] = val & 0xFF;
     data[1] = (val >> 8) & 0xFF;
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (kAddress << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_write(cmd, data, 2, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(100));
-    i2c_cmd_link_delete(cmd);
-
-    return ret == ESP_OK;
+    return device_.write(reg, data, 2) == ESP_OK;
 }
 
 bool Bq27441::read_block(uint8_t reg, uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (kAddress << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (kAddress << 1) | I2C_MASTER_READ, true);
-    if (len > 1) {
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
-    }
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(100));
-    i2c_cmd_link_delete(cmd);
-
-    return ret == ESP_OK;
+    return device_.read(reg, data, len) == ESP_OK;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "gasgauge_driver.h"
 #include "driver/i2c.h"
+#include "i2c_bus/i2c_bus.h"
 
 class Bq27441 : public IGasgaugeDriver
 {
@@ -28,6 +29,6 @@ private:
     bool write_block_data(uint8_t class_id, uint8_t offset, uint8_t *data, uint8_t len);
     bool checksum(uint8_t *check_sum);
 
-    i2c_port_t port_;
     static constexpr uint8_t kAddress = 0x55; // Default I2C address for BQ27441
+    I2cDevice device_;
 };
\ No newline at end of file
@@ -4,7 +4,7 @@
 static const char *TAG = "DS3231";
 
 Ds3231::Ds3231(i2c_port_t port, uint8_t address)
-    : port_(port), address_(address)
+    : device_(port, address, "ds3231", I2cPriority::NORMAL), address_(address)
 {
 }
 
@@ -62,6 +62,17 @@ bool Ds3231::get_temperature(float *temp)
     return true;
 }
 
+bool Ds3231::enable_square_wave(Ds3231SquareWave rate)
+{
+    uint8_t control;
+    if (!read_register(0x0E, &control)) {
+        return false;
+    }
+    control &= ~(0x04 | 0x18); // INTCN=0, clear RS2:RS1
+    control |= static_cast<uint8_t>(rate);
+    return write_register(0x0E, control);
+}
+
 bool Ds3231::set_alarm1(const struct tm *timeinfo)
 {
     // Set Alarm 1 to match seconds, minutes, hours, and day/date
@@ -75,6 +86,27 @@ bool Ds3231::set_alarm1(const struct tm *timeinfo)
     return write_registers(0x07, data, 4);
 }
 
+bool Ds3231::set_alarm1_daily(const struct tm *timeinfo)
+{
+    uint8_t data[4];
+    data[0] = dec2bcd(timeinfo->tm_sec);
+    data[1] = dec2bcd(timeinfo->tm_min);
+    data[2] = dec2bcd(timeinfo->tm_hour);
+    data[3] = 0x80; // A1M4=1: day/date ignored
+
+    return write_registers(0x07, data, 4);
+}
+
+bool Ds3231::alarm1_fired(bool *fired)
+{
+    uint8_t status;
+    if (!read_register(0x0F, &status)) {
+        return false;
+    }
+    *fired = status & 0x01; // A1F
+    return true;
+}
+
 bool Ds3231::clear_alarm1_flag()
 {
     uint8_t status;
@@ -92,7 +124,7 @@ bool Ds3231::enable_alarm1_interrupt(bool enable)
         return false;
     }
     if (enable) {
-        control |= 0x05; // INTCN=1, A1IE=1
+        control |= 0x01; // A1IE=1; INTCN is left to the pin's owner
     } else {
         control &= ~0x01; // A1IE=0
     }
@@ -121,31 +153,10 @@ bool Ds3231::write_register(uint8_t reg, uint8_t val)
 
 bool Ds3231::read_registers(uint8_t reg, uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (address_ << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (address_ << 1) | I2C_MASTER_READ, true);
-    if (len > 1) {
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
-    }
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    return ret == ESP_OK;
+    return device_.read(reg, data, len) == ESP_OK;
 }
 
 bool Ds3231::write_registers(uint8_t reg, const uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (address_ << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_write(cmd, const_cast<uint8_t*>(data), len, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    return ret == ESP_OK;
+    return device_.write(reg, data, len) == ESP_OK;
 }
\ No newline at end of file
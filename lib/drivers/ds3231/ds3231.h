@@ -4,6 +4,16 @@
 #include <ctime>
 #include "driver/i2c.h"
 #include "driver/gpio.h"
+#include "i2c_bus/i2c_bus.h"
+
+// Rate of the INT/SQW output when it is in square-wave mode (RS2:RS1)
+enum class Ds3231SquareWave : uint8_t
+{
+    HZ_1 = 0x00,
+    HZ_1024 = 0x08,
+    HZ_4096 = 0x10,
+    HZ_8192 = 0x18,
+};
 
 class Ds3231
 {
@@ -14,11 +24,22 @@ public:
     bool get_time(struct tm *timeinfo);
     bool set_time(const struct tm *timeinfo);
     bool get_temperature(float *temp);
+
+    // Puts INT/SQW in square-wave mode. At 1 Hz the falling edge marks the
+    // seconds roll-over, and writing the time restarts the countdown so the
+    // edges stay aligned with the registers.
+    bool enable_square_wave(Ds3231SquareWave rate);
     
     // Alarm functions
     // Alarm 1 support
     bool set_alarm1(const struct tm *timeinfo);
+    // Matches hours, minutes and seconds only (A1M4=1), so it fires daily
+    bool set_alarm1_daily(const struct tm *timeinfo);
+    // Reads A1F, set by a match whether or not A1IE is
+    bool alarm1_fired(bool *fired);
     bool clear_alarm1_flag();
+    // Sets A1IE only. The alarm drives INT/SQW low only while the pin is not
+    // in square-wave mode; otherwise it just raises the A1F status flag.
     bool enable_alarm1_interrupt(bool enable);
 
 private:
@@ -29,6 +50,6 @@ private:
     bool read_registers(uint8_t reg, uint8_t *data, size_t len);
     bool write_registers(uint8_t reg, const uint8_t *data, size_t len);
 
-    i2c_port_t port_;
+    I2cDevice device_;
     uint8_t address_;
 };
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "hv57708.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <algorithm>
+
+namespace
+{
+const char *kTag = "hv57708";
+
+// BL is active low (low blanks every output), so the LEDC duty is the share
+// of time the outputs are enabled.
+constexpr ledc_timer_t kBlLedcTimer = LEDC_TIMER_1;
+constexpr ledc_channel_t kBlLedcChannel = LEDC_CHANNEL_1;
+constexpr ledc_timer_bit_t kBlLedcResolution = LEDC_TIMER_10_BIT;
+constexpr uint32_t kBlLedcFullDuty = 1u << 10;
+} // namespace
+
+Hv57708::Hv57708(spi_host_device_t host, const Hv57708Pins &pins)
+    : host_(host), pins_(pins)
+{
+}
+
+Hv57708::~Hv57708()
+{
+    if (device_) {
+        spi_bus_remove_device(device_);
+    }
+    if (bus_ready_) {
+        spi_bus_free(host_);
+    }
+    heap_caps_free(dma_buffer_);
+}
+
+bool Hv57708::init(int clock_hz, uint32_t pwm_frequency_hz)
+{
+    gpio_config_t le_conf = {};
+    le_conf.intr_type = GPIO_INTR_DISABLE;
+    le_conf.mode = GPIO_MODE_OUTPUT;
+    le_conf.pin_bit_mask = (1ULL << pins_.le);
+    if (gpio_config(&le_conf) != ESP_OK) {
+        return false;
+    }
+    gpio_set_level(pins_.le, 0);
+
+    // Allocated once so a frame update never touches the heap
+    dma_buffer_ = static_cast<uint8_t *>(heap_caps_malloc(kFrameBytes, MALLOC_CAP_DMA));
+    if (!dma_buffer_) {
+        ESP_LOGE(kTag, "No DMA memory for the frame buffer");
+        return false;
+    }
+
+    spi_bus_config_t bus_config = {};
+    bus_config.mosi_io_num = pins_.din1;
+    bus_config.miso_io_num = pins_.din2;
+    bus_config.quadwp_io_num = pins_.din3;
+    bus_config.quadhd_io_num = pins_.din4;
+    bus_config.sclk_io_num = pins_.clk;
+    bus_config.max_transfer_sz = kFrameBytes;
+    if (spi_bus_initialize(host_, &bus_config, SPI_DMA_CH_AUTO) != ESP_OK) {
+        ESP_LOGE(kTag, "SPI bus init failed");
+        return false;
+    }
+    bus_ready_ = true;
+
+    spi_device_interface_config_t device_config = {};
+    device_config.mode = 0;
+    device_config.clock_speed_hz = clock_hz;
+    device_config.spics_io_num = -1; // LE is pulsed after the shift instead
+    device_config.flags = SPI_DEVICE_HALFDUPLEX;
+    device_config.queue_size = 1;
+    if (spi_bus_add_device(host_, &device_config, &device_) != ESP_OK) {
+        ESP_LOGE(kTag, "SPI device add failed");
+        return false;
+    }
+
+    ledc_timer_config_t timer_config = {};
+    timer_config.speed_mode = LEDC_LOW_SPEED_MODE;
+    timer_config.duty_resolution = kBlLedcResolution;
+    timer_config.timer_num = kBlLedcTimer;
+    timer_config.freq_hz = pwm_frequency_hz;
+    timer_config.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer_config) != ESP_OK) {
+        ESP_LOGE(kTag, "BL timer init failed");
+        return false;
+    }
+
+    ledc_channel_config_t channel_config = {};
+    channel_config.gpio_num = pins_.bl;
+    channel_config.speed_mode = LEDC_LOW_SPEED_MODE;
+    channel_config.channel = kBlLedcChannel;
+    channel_config.intr_type = LEDC_INTR_DISABLE;
+    channel_config.timer_sel = kBlLedcTimer;
+    channel_config.duty = 0; // blanked until the first brightness is set
+    channel_config.hpoint = 0;
+    if (ledc_channel_config(&channel_config) != ESP_OK) {
+        ESP_LOGE(kTag, "BL channel init failed");
+        return false;
+    }
+    dimming_ready_ = true;
+
+    ESP_LOGI(kTag, "HV57708 initialized (%d Hz SPI)", clock_hz);
+    return true;
+}
+
+bool Hv57708::write(uint64_t outputs)
+{
+    if (!device_) {
+        return false;
+    }
+    const Frame frame = encode(outputs);
+    std::copy(frame.begin(), frame.end(), dma_buffer_);
+
+    spi_transaction_t transaction = {};
+    transaction.flags = SPI_TRANS_MODE_QIO;
+    transaction.length = kFrameBytes * 8;
+    transaction.tx_buffer = dma_buffer_;
+    if (spi_device_polling_transmit(device_, &transaction) != ESP_OK) {
+        return false;
+    }
+
+    // Latches follow the shift registers while LE is high
+    gpio_set_level(pins_.le, 1);
+    gpio_set_level(pins_.le, 0);
+    return true;
+}
+
+bool Hv57708::set_brightness(uint8_t brightness)
+{
+    if (!dimming_ready_) {
+        return false;
+    }
+    const uint32_t duty = (static_cast<uint32_t>(brightness) * kBlLedcFullDuty) / 255;
+    if (ledc_set_duty(LEDC_LOW_SPEED_MODE, kBlLedcChannel, duty) != ESP_OK) {
+        return false;
+    }
+    return ledc_update_duty(LEDC_LOW_SPEED_MODE, kBlLedcChannel) == ESP_OK;
+}
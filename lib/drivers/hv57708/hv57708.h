@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/spi_master.h"
+#include "hv57708_bitstream.h"
+
+struct Hv57708Pins
+{
+    gpio_num_t clk;
+    gpio_num_t din1; // SPI D0 (MOSI)
+    gpio_num_t din2; // SPI D1 (MISO)
+    gpio_num_t din3; // SPI D2 (WP)
+    gpio_num_t din4; // SPI D3 (HD)
+    gpio_num_t le;
+    gpio_num_t bl;
+};
+
+// HV57708 64-channel serial-to-parallel converter. Its four 16-bit shift
+// registers are fed in parallel from a quad-SPI data phase, so a whole frame
+// is 16 clocks, latched with a pulse on LE. BL is driven from LEDC so its
+// duty cycle dims every output at once.
+class Hv57708 : public Hv57708Bitstream
+{
+public:
+    Hv57708(spi_host_device_t host, const Hv57708Pins &pins);
+    ~Hv57708();
+
+    bool init(int clock_hz, uint32_t pwm_frequency_hz);
+    bool write(uint64_t outputs);
+    bool set_brightness(uint8_t brightness);
+
+private:
+    spi_host_device_t host_;
+    Hv57708Pins pins_;
+    spi_device_handle_t device_ = nullptr;
+    uint8_t *dma_buffer_ = nullptr;
+    bool bus_ready_ = false;
+    bool dimming_ready_ = false;
+};
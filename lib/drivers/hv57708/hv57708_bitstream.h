@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Bit layout of one HV57708 frame, apart from the SPI driver so it also
+// builds on the host
+struct Hv57708Bitstream
+{
+    static constexpr size_t kOutputCount = 64;
+    static constexpr size_t kFrameBytes = kOutputCount / 8;
+    static constexpr size_t kClocksPerFrame = kOutputCount / 4;
+    using Frame = std::array<uint8_t, kFrameBytes>;
+
+    // Bit n of |outputs| drives HVOUT(n + 1). DINk shifts through
+    // HVOUTk, HVOUTk+4, ... so each clock carries one nibble of outputs, and
+    // the first nibble clocked in ends up furthest from the inputs. In quad
+    // mode the SPI peripheral sends the high nibble of each byte first, with
+    // bit 0 of a nibble on D0.
+    static Frame encode(uint64_t outputs)
+    {
+        Frame frame{};
+        for (size_t clock = 0; clock < kClocksPerFrame; ++clock) {
+            const size_t group = kClocksPerFrame - 1 - clock;
+            const uint8_t nibble = static_cast<uint8_t>((outputs >> (4 * group)) & 0x0F);
+            frame[clock / 2] |= (clock % 2 == 0) ? static_cast<uint8_t>(nibble << 4) : nibble;
+        }
+        return frame;
+    }
+};
@@ -0,0 +1,362 @@
+#include "i2c_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <algorithm>
+
+namespace
+{
+const char *kTag = "I2cBus";
+
+constexpr int64_t kUsPerTick = static_cast<int64_t>(portTICK_PERIOD_MS) * 1000;
+// Floor for the driver's own timeout. One tick can run out at the very next
+// tick interrupt, microseconds into a healthy transfer, and the driver then
+// resets the bus. A late transfer still shows up as a deadline miss.
+constexpr TickType_t kMinTransferTicks = 2;
+
+// Budget for queueing plus transfer, indexed by I2cPriority
+constexpr uint32_t kDefaultDeadlineUs[] = {
+    2000,   // REALTIME: one scan step
+    50000,  // NORMAL
+    100000, // BACKGROUND
+};
+
+I2cBus *g_buses[I2C_NUM_MAX] = {};
+
+bool runs_before(I2cPriority priority, int64_t deadline_us,
+                 I2cPriority other_priority, int64_t other_deadline_us)
+{
+    if (priority != other_priority) {
+        return priority < other_priority;
+    }
+    return deadline_us < other_deadline_us;
+}
+} // namespace
+
+I2cBus &I2cBus::install(i2c_port_t port)
+{
+    if (!g_buses[port]) {
+        g_buses[port] = new I2cBus(port);
+    }
+    return *g_buses[port];
+}
+
+I2cBus *I2cBus::find(i2c_port_t port)
+{
+    if (port < 0 || port >= I2C_NUM_MAX) {
+        return nullptr;
+    }
+    return g_buses[port];
+}
+
+I2cBus::I2cBus(i2c_port_t port)
+    : port_(port)
+{
+    for (auto &waiter : waiters_) {
+        waiter.wake = xSemaphoreCreateBinary();
+    }
+    stats_since_us_ = esp_timer_get_time();
+}
+
+i2c_port_t I2cBus::port() const
+{
+    return port_;
+}
+
+int I2cBus::register_device(uint8_t address, const char *name, I2cPriority priority)
+{
+    taskENTER_CRITICAL(&lock_);
+    if (device_count_ >= stats_.size()) {
+        taskEXIT_CRITICAL(&lock_);
+        ESP_LOGW(kTag, "No stats slot left for %s@0x%02x", name, address);
+        return -1;
+    }
+    const int slot = static_cast<int>(device_count_++);
+    stats_[slot] = {};
+    stats_[slot].name = name;
+    stats_[slot].address = address;
+    stats_[slot].priority = priority;
+    taskEXIT_CRITICAL(&lock_);
+    return slot;
+}
+
+esp_err_t I2cBus::write(int device, uint8_t address, uint8_t reg, const uint8_t *data, size_t length,
+                        I2cPriority priority, uint32_t deadline_us)
+{
+    const int64_t requested_us = esp_timer_get_time();
+    const int64_t deadline = requested_us + deadline_us;
+    esp_err_t result = acquire(priority, deadline);
+    if (result != ESP_OK) {
+        record(device, 0, requested_us, esp_timer_get_time(), deadline, result);
+        return result;
+    }
+    const int64_t granted_us = esp_timer_get_time();
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(cmd_buffer_.data(), cmd_buffer_.size());
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, static_cast<uint8_t>((address << 1) | I2C_MASTER_WRITE), true);
+    i2c_master_write_byte(cmd, reg, true);
+    i2c_master_write(cmd, data, length, true);
+    i2c_master_stop(cmd);
+    result = run(cmd, deadline);
+
+    record(device, length + 2, requested_us, granted_us, deadline, result);
+    release();
+    return result;
+}
+
+esp_err_t I2cBus::read(int device, uint8_t address, uint8_t reg, uint8_t *data, size_t length,
+                       I2cPriority priority, uint32_t deadline_us)
+{
+    if (length == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const int64_t requested_us = esp_timer_get_time();
+    const int64_t deadline = requested_us + deadline_us;
+    esp_err_t result = acquire(priority, deadline);
+    if (result != ESP_OK) {
+        record(device, 0, requested_us, esp_timer_get_time(), deadline, result);
+        return result;
+    }
+    const int64_t granted_us = esp_timer_get_time();
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(cmd_buffer_.data(), cmd_buffer_.size());
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, static_cast<uint8_t>((address << 1) | I2C_MASTER_WRITE), true);
+    i2c_master_write_byte(cmd, reg, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, static_cast<uint8_t>((address << 1) | I2C_MASTER_READ), true);
+    i2c_master_read(cmd, data, length, I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+    result = run(cmd, deadline);
+
+    record(device, length + 3, requested_us, granted_us, deadline, result);
+    release();
+    return result;
+}
+
+esp_err_t I2cBus::write_batch(int device, const I2cWriteSegment *segments, size_t count,
+                              I2cPriority priority, uint32_t deadline_us)
+{
+    if (count == 0 || count > kMaxBatchSegments) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const int64_t requested_us = esp_timer_get_time();
+    const int64_t deadline = requested_us + deadline_us;
+    esp_err_t result = acquire(priority, deadline);
+    if (result != ESP_OK) {
+        record(device, 0, requested_us, esp_timer_get_time(), deadline, result);
+        return result;
+    }
+    const int64_t granted_us = esp_timer_get_time();
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(cmd_buffer_.data(), cmd_buffer_.size());
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const I2cWriteSegment &segment = segments[i];
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, static_cast<uint8_t>((segment.address << 1) | I2C_MASTER_WRITE), true);
+        i2c_master_write_byte(cmd, segment.reg, true);
+        i2c_master_write(cmd, segment.data, segment.length, true);
+        bytes += segment.length + 2;
+    }
+    i2c_master_stop(cmd);
+    result = run(cmd, deadline);
+
+    record(device, bytes, requested_us, granted_us, deadline, result);
+    release();
+    return result;
+}
+
+esp_err_t I2cBus::run(i2c_cmd_handle_t cmd, int64_t deadline_us)
+{
+    if (!cmd) {
+        ESP_LOGE(kTag, "Command link does not fit in %u bytes", static_cast<unsigned>(kCmdLinkSize));
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t result = i2c_master_cmd_begin(port_, cmd, std::max(ticks_until(deadline_us), kMinTransferTicks));
+    i2c_cmd_link_delete_static(cmd);
+    return result;
+}
+
+esp_err_t I2cBus::acquire(I2cPriority priority, int64_t deadline_us)
+{
+    taskENTER_CRITICAL(&lock_);
+    if (!busy_) {
+        busy_ = true;
+        taskEXIT_CRITICAL(&lock_);
+        return ESP_OK;
+    }
+    Waiter *slot = nullptr;
+    for (auto &waiter : waiters_) {
+        if (!waiter.in_use) {
+            slot = &waiter;
+            break;
+        }
+    }
+    if (!slot) {
+        taskEXIT_CRITICAL(&lock_);
+        return ESP_ERR_NO_MEM;
+    }
+    slot->in_use = true;
+    slot->granted = false;
+    slot->priority = priority;
+    slot->deadline_us = deadline_us;
+    taskEXIT_CRITICAL(&lock_);
+
+    while (true) {
+        xSemaphoreTake(slot->wake, ticks_until(deadline_us));
+
+        // A grant may race with the timeout, so the flag is the only truth
+        taskENTER_CRITICAL(&lock_);
+        if (slot->granted) {
+            slot->in_use = false;
+            taskEXIT_CRITICAL(&lock_);
+            return ESP_OK;
+        }
+        if (esp_timer_get_time() >= deadline_us) {
+            slot->in_use = false;
+            taskEXIT_CRITICAL(&lock_);
+            return ESP_ERR_TIMEOUT;
+        }
+        taskEXIT_CRITICAL(&lock_);
+    }
+}
+
+void I2cBus::release()
+{
+    Waiter *next = nullptr;
+    taskENTER_CRITICAL(&lock_);
+    for (auto &waiter : waiters_) {
+        if (!waiter.in_use || waiter.granted) {
+            continue;
+        }
+        if (!next || runs_before(waiter.priority, waiter.deadline_us, next->priority, next->deadline_us)) {
+            next = &waiter;
+        }
+    }
+    if (next) {
+        // Ownership passes straight to the waiter, busy_ stays set
+        next->granted = true;
+    } else {
+        busy_ = false;
+    }
+    taskEXIT_CRITICAL(&lock_);
+
+    if (next) {
+        xSemaphoreGive(next->wake);
+    }
+}
+
+void I2cBus::record(int device, size_t bytes, int64_t requested_us, int64_t granted_us,
+                    int64_t deadline_us, esp_err_t result)
+{
+    if (device < 0 || static_cast<size_t>(device) >= device_count_) {
+        return;
+    }
+    const int64_t now = esp_timer_get_time();
+    const uint32_t wait_us = static_cast<uint32_t>(granted_us - requested_us);
+
+    taskENTER_CRITICAL(&lock_);
+    I2cDeviceStats &stats = stats_[device];
+    stats.transactions++;
+    stats.bytes += static_cast<uint32_t>(bytes);
+    stats.wait_us += wait_us;
+    stats.max_wait_us = std::max(stats.max_wait_us, wait_us);
+    if (result == ESP_OK) {
+        stats.busy_us += static_cast<uint64_t>(now - granted_us);
+    } else {
+        stats.errors++;
+    }
+    if (now > deadline_us) {
+        stats.deadline_misses++;
+    }
+    taskEXIT_CRITICAL(&lock_);
+}
+
+TickType_t I2cBus::ticks_until(int64_t deadline_us) const
+{
+    const int64_t remaining = deadline_us - esp_timer_get_time();
+    if (remaining <= 0) {
+        return 1;
+    }
+    return static_cast<TickType_t>((remaining + kUsPerTick - 1) / kUsPerTick);
+}
+
+size_t I2cBus::get_stats(I2cDeviceStats *out, size_t max_count) const
+{
+    taskENTER_CRITICAL(&lock_);
+    const size_t count = std::min(max_count, device_count_);
+    std::copy(stats_.begin(), stats_.begin() + count, out);
+    taskEXIT_CRITICAL(&lock_);
+    return count;
+}
+
+int64_t I2cBus::stats_window_us() const
+{
+    return esp_timer_get_time() - stats_since_us_;
+}
+
+void I2cBus::reset_stats()
+{
+    taskENTER_CRITICAL(&lock_);
+    for (size_t i = 0; i < device_count_; ++i) {
+        I2cDeviceStats &stats = stats_[i];
+        stats = {stats.name, stats.address, stats.priority, 0, 0, 0, 0, 0, 0, 0};
+    }
+    stats_since_us_ = esp_timer_get_time();
+    taskEXIT_CRITICAL(&lock_);
+}
+
+I2cDevice::I2cDevice(i2c_port_t port, uint8_t address, const char *name, I2cPriority priority)
+    : port_(port),
+      address_(address),
+      name_(name),
+      priority_(priority),
+      deadline_us_(kDefaultDeadlineUs[static_cast<size_t>(priority)])
+{
+}
+
+esp_err_t I2cDevice::write(uint8_t reg, const uint8_t *data, size_t length)
+{
+    I2cBus *bus_handle = bus();
+    if (!bus_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return bus_handle->write(slot_, address_, reg, data, length, priority_, deadline_us_);
+}
+
+esp_err_t I2cDevice::read(uint8_t reg, uint8_t *data, size_t length)
+{
+    I2cBus *bus_handle = bus();
+    if (!bus_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return bus_handle->read(slot_, address_, reg, data, length, priority_, deadline_us_);
+}
+
+esp_err_t I2cDevice::write_batch(const I2cWriteSegment *segments, size_t count)
+{
+    I2cBus *bus_handle = bus();
+    if (!bus_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return bus_handle->write_batch(slot_, segments, count, priority_, deadline_us_);
+}
+
+uint8_t I2cDevice::address() const
+{
+    return address_;
+}
+
+I2cBus *I2cDevice::bus()
+{
+    if (!bus_) {
+        bus_ = I2cBus::find(port_);
+        if (!bus_) {
+            ESP_LOGE(kTag, "I2C port %d has no bus arbiter installed", port_);
+            return nullptr;
+        }
+        slot_ = bus_->register_device(address_, name_, priority_);
+    }
+    return bus_;
+}
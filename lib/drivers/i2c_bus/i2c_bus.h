@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+enum class I2cPriority : uint8_t
+{
+    REALTIME,  // nixie scan, never queues behind anything else
+    NORMAL,    // RTC and user-triggered configuration
+    BACKGROUND // periodic telemetry
+};
+
+struct I2cDeviceStats
+{
+    const char *name;
+    uint8_t address;
+    I2cPriority priority;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t deadline_misses;
+    uint32_t bytes;
+    uint64_t busy_us;
+    uint64_t wait_us;
+    uint32_t max_wait_us;
+};
+
+// One register write inside a compound transfer. Segments are chained with
+// repeated STARTs, so each may address a different device.
+struct I2cWriteSegment
+{
+    uint8_t address;
+    uint8_t reg;
+    const uint8_t *data;
+    size_t length;
+};
+
+// Arbiter for one I2C controller. Every transaction carries a priority and a
+// deadline; when the bus is released it is handed to the waiting transaction
+// with the highest priority, earliest deadline first within a priority.
+class I2cBus
+{
+public:
+    static constexpr size_t kMaxDevices = 12;
+    static constexpr size_t kMaxWaiters = 8;
+    static constexpr size_t kMaxBatchSegments = 4;
+
+    // Call once after i2c_driver_install()
+    static I2cBus &install(i2c_port_t port);
+    static I2cBus *find(i2c_port_t port);
+
+    i2c_port_t port() const;
+    int register_device(uint8_t address, const char *name, I2cPriority priority);
+
+    // |deadline_us| is the budget from now for queueing plus the transfer
+    esp_err_t write(int device, uint8_t address, uint8_t reg, const uint8_t *data, size_t length,
+                    I2cPriority priority, uint32_t deadline_us);
+    esp_err_t read(int device, uint8_t address, uint8_t reg, uint8_t *data, size_t length,
+                   I2cPriority priority, uint32_t deadline_us);
+    // Up to kMaxBatchSegments writes in one transaction with a single STOP
+    esp_err_t write_batch(int device, const I2cWriteSegment *segments, size_t count,
+                          I2cPriority priority, uint32_t deadline_us);
+
+    size_t get_stats(I2cDeviceStats *out, size_t max_count) const;
+    int64_t stats_window_us() const;
+    void reset_stats();
+
+private:
+    struct Waiter
+    {
+        SemaphoreHandle_t wake;
+        I2cPriority priority;
+        int64_t deadline_us;
+        bool in_use;
+        bool granted;
+    };
+
+    explicit I2cBus(i2c_port_t port);
+
+    esp_err_t acquire(I2cPriority priority, int64_t deadline_us);
+    void release();
+    void record(int device, size_t bytes, int64_t requested_us, int64_t granted_us,
+                int64_t deadline_us, esp_err_t result);
+    TickType_t ticks_until(int64_t deadline_us) const;
+    esp_err_t run(i2c_cmd_handle_t cmd, int64_t deadline_us);
+
+    // Command links for the transaction in flight are built here, so no
+    // transfer touches the heap. Only the bus owner may use it. A batch
+    // segment needs four command items, one fewer than the IDF sizing
+    // assumes per transaction, which leaves room for the final STOP.
+    static constexpr size_t kCmdLinkSize = I2C_LINK_RECOMMENDED_SIZE(kMaxBatchSegments);
+
+    i2c_port_t port_;
+    std::array<uint8_t, kCmdLinkSize> cmd_buffer_{};
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    bool busy_ = false;
+    std::array<Waiter, kMaxWaiters> waiters_{};
+    std::array<I2cDeviceStats, kMaxDevices> stats_{};
+    size_t device_count_ = 0;
+    int64_t stats_since_us_ = 0;
+};
+
+// Register-oriented handle drivers use to reach their chip through the bus
+// arbiter. The bus is looked up lazily so drivers may be constructed before
+// SystemController::init_hardware() has installed it.
+class I2cDevice
+{
+public:
+    I2cDevice(i2c_port_t port, uint8_t address, const char *name,
+              I2cPriority priority = I2cPriority::NORMAL);
+
+    esp_err_t write(uint8_t reg, const uint8_t *data, size_t length);
+    esp_err_t read(uint8_t reg, uint8_t *data, size_t length);
+    // Segments carry their own addresses; this device only owns the stats
+    esp_err_t write_batch(const I2cWriteSegment *segments, size_t count);
+
+    uint8_t address() const;
+
+private:
+    I2cBus *bus();
+
+    i2c_port_t port_;
+    uint8_t address_;
+    const char *name_;
+    I2cPriority priority_;
+    uint32_t deadline_us_;
+    I2cBus *bus_ = nullptr;
+    int slot_ = -1;
+};
@@ -22,7 +22,7 @@ static constexpr uint8_t kRegDieId = 0xFF;
 static constexpr uint16_t kConfigValue = 0x7127;
 
 Ina3221::Ina3221(i2c_port_t port, uint8_t address)
-    : port_(port), address_(address)
+    : device_(port, address, "ina3221", I2cPriority::BACKGROUND)
 {
     // Default shunt resistors (0.1 Ohm = 100 mOhm)
     // Adjust these if your hardware uses different values
@@ -158,33 +158,13 @@ bool Ina3221::write_register(uint8_t reg, uint16_t val)
     data[0] = (val >> 8) & 0xFF; // MSB
     data[1] = val & 0xFF;        // LSB
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (address_ << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_write(cmd, data, 2, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(100));
-    i2c_cmd_link_delete(cmd);
-
-    return ret == ESP_OK;
+    return device_.write(reg, data, 2) == ESP_OK;
 }
 
 bool Ina3221::read_register(uint8_t reg, uint16_t *val)
 {
     uint8_t data[2];
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (address_ << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (address_ << 1) | I2C_MASTER_READ, true);
-    i2c_master_read(cmd, data, 2, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(100));
-    i2c_cmd_link_delete(cmd);
-
-    if (ret == ESP_OK) {
+    if (device_.read(reg, data, 2) == ESP_OK) {
         *val = (data[0] << 8) | data[1]; // MSB first
         return true;
     }
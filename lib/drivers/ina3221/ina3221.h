@@ -2,6 +2,7 @@
 
 #include "powermonitor_driver.h"
 #include "driver/i2c.h"
+#include "i2c_bus/i2c_bus.h"
 
 class Ina3221 : public IPowerMonitorDriver
 {
@@ -31,6 +32,5 @@ private:
     float shunt_resistor_mv_ma_[3]; // Shunt resistance in mOhm? No, usually Ohm. 
                                     // Let's store in Ohms.
                                     
-    i2c_port_t port_;
-    uint8_t address_;
+    I2cDevice device_;
 };
\ No newline at end of file
@@ -1,45 +1,56 @@
 #include "pca9685.h"
 #include "freertos/FreeRTOS.h"
+#include "esp_rom_sys.h"
+#include <algorithm>
 
 namespace
 {
 constexpr uint8_t kMode1 = 0x00;
 constexpr uint8_t kMode2 = 0x01;
+constexpr uint8_t kSubAdr1 = 0x02;
+constexpr uint8_t kAllCallAdr = 0x05;
 constexpr uint8_t kPrescale = 0xFE;
 constexpr uint8_t kLed0OnL = 0x06;
-constexpr uint8_t kAllLedOffL = 0xFC;
+constexpr uint8_t kAllLedOnL = 0xFA;
 
 constexpr uint8_t kMode1Sleep = 0x10;
 constexpr uint8_t kMode1Restart = 0x80;
 constexpr uint8_t kMode1AutoInc = 0x20;
+constexpr uint8_t kMode1AllCall = 0x01;
+constexpr uint8_t kMode1Sub1 = 0x08; // SUB2 and SUB3 follow in the lower bits
 constexpr uint8_t kMode2TotemPole = 0x04;
+constexpr uint8_t kLedFullBit = 0x10; // bit 4 of LEDn_ON_H / LEDn_OFF_H
+constexpr uint8_t kMode1Default = kMode1AutoInc | kMode1AllCall; // as init() leaves it
+constexpr uint32_t kOscillatorStartUs = 500;
 
-constexpr float kOscillatorHz = 25000000.0f;
+// A clean gap this short costs less to rewrite than the address and register
+// bytes of a separate burst, so dirty runs closer than this are merged.
+constexpr size_t kBurstMergeGap = 2;
+
+// ALL_LED_ON_L..ALL_LED_OFF_H for full off, also what every LEDn holds after
+constexpr uint8_t kAllOffPattern[4] = {0x00, 0x00, 0x00, 0x10};
 } // namespace
 
-Pca9685::Pca9685(i2c_port_t port, uint8_t address)
-    : port_(port), address_(address)
+Pca9685::Pca9685(i2c_port_t port, uint8_t address, I2cPriority priority)
+    : device_(port, address, "pca9685", priority)
 {
 }
 
 bool Pca9685::init(float pwm_frequency_hz)
 {
-    const uint8_t mode1 = kMode1AutoInc;
+    const uint8_t mode1 = kMode1Default;
     if (!write_register(kMode1, mode1)) {
         return false;
     }
+    mode1_ = mode1;
+    if (!write_register(kAllCallAdr, static_cast<uint8_t>(kAllCallAddress << 1))) {
+        return false;
+    }
     if (!write_register(kMode2, kMode2TotemPole)) {
         return false;
     }
 
-    float prescale_f = (kOscillatorHz / (4096.0f * pwm_frequency_hz)) - 1.0f;
-    if (prescale_f < 3.0f) {
-        prescale_f = 3.0f;
-    }
-    if (prescale_f > 255.0f) {
-        prescale_f = 255.0f;
-    }
-    const uint8_t prescale = static_cast<uint8_t>(prescale_f + 0.5f);
+    const uint8_t prescale = prescale_for(pwm_frequency_hz);
 
     if (!write_register(kMode1, static_cast<uint8_t>(mode1 | kMode1Sleep))) {
         return false;
@@ -56,6 +67,23 @@ bool Pca9685::init(float pwm_frequency_hz)
     return true;
 }
 
+bool Pca9685::set_sub_address(uint8_t index, uint8_t address, bool enable)
+{
+    if (index < 1 || index > 3) {
+        return false;
+    }
+    if (!write_register(static_cast<uint8_t>(kSubAdr1 + index - 1), static_cast<uint8_t>(address << 1))) {
+        return false;
+    }
+    const uint8_t bit = static_cast<uint8_t>(kMode1Sub1 >> (index - 1));
+    const uint8_t mode1 = enable ? static_cast<uint8_t>(mode1_ | bit) : static_cast<uint8_t>(mode1_ & ~bit);
+    if (!write_register(kMode1, mode1)) {
+        return false;
+    }
+    mode1_ = mode1;
+    return true;
+}
+
 bool Pca9685::set_pwm(uint8_t channel, uint16_t on, uint16_t off)
 {
     if (channel >= 16) {
@@ -68,7 +96,12 @@ bool Pca9685::set_pwm(uint8_t channel, uint16_t on, uint16_t off)
         static_cast<uint8_t>(off & 0xFF),
         static_cast<uint8_t>((off >> 8) & 0x0F)
     };
-    return write_registers(reg, data, sizeof(data));
+    if (!write_registers(reg, data, sizeof(data))) {
+        return false;
+    }
+    std::copy(data, data + sizeof(data), &shadow_[4 * channel]);
+    std::copy(data, data + sizeof(data), &chip_[4 * channel]);
+    return true;
 }
 
 bool Pca9685::set_duty(uint8_t channel, uint16_t duty)
@@ -81,8 +114,75 @@ bool Pca9685::set_duty(uint8_t channel, uint16_t duty)
 
 bool Pca9685::set_all_off()
 {
-    uint8_t data[4] = {0x00, 0x00, 0x00, 0x10};
-    return write_registers(kAllLedOffL, data, sizeof(data));
+    // ALL_LED_ON_L..ALL_LED_OFF_H load every LEDn register at once
+    if (!write_registers(kAllLedOnL, kAllOffPattern, sizeof(kAllOffPattern))) {
+        return false;
+    }
+    for (size_t offset = 0; offset < kRegisterFileSize; offset += 4) {
+        std::copy(kAllOffPattern, kAllOffPattern + sizeof(kAllOffPattern), &chip_[offset]);
+    }
+    shadow_ = chip_;
+    chip_valid_ = true;
+    return true;
+}
+
+void Pca9685::stage_pwm(uint8_t channel, uint16_t on, uint16_t off)
+{
+    if (channel >= kChannelCount) {
+        return;
+    }
+    uint8_t *regs = &shadow_[4 * channel];
+    regs[0] = static_cast<uint8_t>(on & 0xFF);
+    regs[1] = static_cast<uint8_t>((on >> 8) & 0x0F);
+    regs[2] = static_cast<uint8_t>(off & 0xFF);
+    regs[3] = static_cast<uint8_t>((off >> 8) & 0x0F);
+}
+
+void Pca9685::stage_duty(uint8_t channel, uint16_t duty)
+{
+    stage_pwm(channel, 0, std::min<uint16_t>(duty, 4095));
+}
+
+void Pca9685::stage_off(uint8_t channel)
+{
+    if (channel >= kChannelCount) {
+        return;
+    }
+    // Full-off overrides the counts, so only LEDn_OFF_H has to change and the
+    // old counts survive for the next time the channel is lit.
+    shadow_[4 * channel + 3] |= kLedFullBit;
+}
+
+void Pca9685::stage_all_off()
+{
+    for (uint8_t channel = 0; channel < kChannelCount; ++channel) {
+        stage_off(channel);
+    }
+}
+
+bool Pca9685::flush()
+{
+    bool ok = true;
+    size_t end = 0;
+    size_t start = next_burst(0, &end);
+    while (start < kRegisterFileSize) {
+        const uint8_t reg = static_cast<uint8_t>(kLed0OnL + start);
+        if (write_registers(reg, &shadow_[start], end - start)) {
+            std::copy(shadow_.begin() + start, shadow_.begin() + end, chip_.begin() + start);
+        } else {
+            ok = false;
+        }
+        start = next_burst(end, &end);
+    }
+    if (ok) {
+        chip_valid_ = true;
+    }
+    return ok;
+}
+
+uint32_t Pca9685::bytes_written() const
+{
+    return bytes_written_;
 }
 
 bool Pca9685::write_register(uint8_t reg, uint8_t value)
@@ -92,13 +192,141 @@ bool Pca9685::write_register(uint8_t reg, uint8_t value)
 
 bool Pca9685::write_registers(uint8_t reg, const uint8_t *data, size_t length)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, static_cast<uint8_t>(address_ << 1), true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_write(cmd, const_cast<uint8_t *>(data), length, true);
-    i2c_master_stop(cmd);
-    esp_err_t result = i2c_master_cmd_begin(port_, cmd, pdMS_TO_TICKS(50));
-    i2c_cmd_link_delete(cmd);
+    esp_err_t result = device_.write(reg, data, length);
+    bytes_written_ += static_cast<uint32_t>(length + 2);
     return result == ESP_OK;
 }
+
+size_t Pca9685::next_dirty(size_t from) const
+{
+    if (!chip_valid_) {
+        return from;
+    }
+    while (from < kRegisterFileSize && shadow_[from] == chip_[from]) {
+        ++from;
+    }
+    return from;
+}
+
+size_t Pca9685::next_burst(size_t from, size_t *end) const
+{
+    const size_t start = next_dirty(from);
+    if (start >= kRegisterFileSize) {
+        *end = kRegisterFileSize;
+        return start;
+    }
+    *end = start + 1;
+    size_t next = next_dirty(*end);
+    while (next < kRegisterFileSize && next - *end <= kBurstMergeGap) {
+        *end = next + 1;
+        next = next_dirty(*end);
+    }
+    return start;
+}
+
+void Pca9685::assume_blanked()
+{
+    // A broadcast ALL_LED write loads the all-off pattern into every LEDn,
+    // counts included. Staged full-off channels take the same pattern so
+    // they do not differ from the chip afterwards.
+    for (size_t offset = 0; offset < kRegisterFileSize; offset += 4) {
+        if (shadow_[offset + 3] & kLedFullBit) {
+            std::copy(kAllOffPattern, kAllOffPattern + sizeof(kAllOffPattern), &shadow_[offset]);
+        }
+        std::copy(kAllOffPattern, kAllOffPattern + sizeof(kAllOffPattern), &chip_[offset]);
+    }
+    chip_valid_ = true;
+}
+
+size_t Pca9685::pending_bursts(I2cWriteSegment *out, size_t max_count) const
+{
+    size_t count = 0;
+    size_t end = 0;
+    size_t start = next_burst(0, &end);
+    while (start < kRegisterFileSize) {
+        if (count < max_count) {
+            out[count] = {device_.address(), static_cast<uint8_t>(kLed0OnL + start),
+                          &shadow_[start], end - start};
+        }
+        ++count;
+        start = next_burst(end, &end);
+    }
+    return count;
+}
+
+void Pca9685::mark_flushed(bool ok)
+{
+    if (ok) {
+        chip_ = shadow_;
+    } else {
+        // Unknown what reached the chip, so the next flush rewrites it all
+        chip_valid_ = false;
+    }
+}
+
+Pca9685Group::Pca9685Group(i2c_port_t port, uint8_t address, I2cPriority priority)
+    : device_(port, address, "pca9685*", priority)
+{
+}
+
+bool Pca9685Group::blank_and_flush(Pca9685 *members, size_t count)
+{
+    std::array<I2cWriteSegment, I2cBus::kMaxBatchSegments> segments;
+    segments[0] = {device_.address(), kAllLedOnL, kAllOffPattern, sizeof(kAllOffPattern)};
+    size_t used = 1;
+    bool fits = true;
+    for (size_t i = 0; i < count; ++i) {
+        members[i].assume_blanked();
+        const size_t room = segments.size() - used;
+        const size_t bursts = members[i].pending_bursts(&segments[used], room);
+        if (bursts > room) {
+            fits = false;
+        } else {
+            used += bursts;
+        }
+    }
+
+    if (!fits) {
+        const bool blanked = device_.write(kAllLedOnL, kAllOffPattern, sizeof(kAllOffPattern)) == ESP_OK;
+        bytes_written_ += sizeof(kAllOffPattern) + 2;
+        bool ok = blanked;
+        for (size_t i = 0; i < count; ++i) {
+            if (!blanked) {
+                members[i].mark_flushed(false);
+            }
+            ok = members[i].flush() && ok;
+        }
+        return ok;
+    }
+
+    const bool ok = device_.write_batch(segments.data(), used) == ESP_OK;
+    for (size_t i = 0; i < used; ++i) {
+        bytes_written_ += static_cast<uint32_t>(segments[i].length + 2);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        members[i].mark_flushed(ok);
+    }
+    return ok;
+}
+
+bool Pca9685Group::restart_counters(uint32_t period_us)
+{
+    // SLEEP only takes hold at the end of each chip's current period, and
+    // RESTART is only armed once it has. The final write then starts every
+    // counter at the same STOP condition.
+    const uint8_t sleep = kMode1Default | kMode1Sleep;
+    const uint8_t wake = kMode1Default;
+    const uint8_t restart = kMode1Default | kMode1Restart;
+    bool ok = device_.write(kMode1, &sleep, 1) == ESP_OK;
+    esp_rom_delay_us(period_us);
+    ok = device_.write(kMode1, &wake, 1) == ESP_OK && ok;
+    esp_rom_delay_us(kOscillatorStartUs);
+    ok = device_.write(kMode1, &restart, 1) == ESP_OK && ok;
+    bytes_written_ += 3 * 3;
+    return ok;
+}
+
+uint32_t Pca9685Group::bytes_written() const
+{
+    return bytes_written_;
+}
@@ -1,24 +1,101 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstddef>
 #include "driver/i2c.h"
 #include "driver/gpio.h"
+#include "i2c_bus/i2c_bus.h"
 
 class Pca9685
 {
 public:
-    Pca9685(i2c_port_t port, uint8_t address);
+    static constexpr uint8_t kChannelCount = 16;
+    static constexpr uint8_t kAllCallAddress = 0x70; // power-on ALLCALLADR
+    static constexpr float kOscillatorHz = 25000000.0f; // internal, typical
 
+    // PRE_SCALE for the nearest reachable frequency, 24 Hz..1526 Hz
+    static constexpr uint8_t prescale_for(float pwm_frequency_hz)
+    {
+        const float prescale = (kOscillatorHz / (4096.0f * pwm_frequency_hz)) - 1.0f;
+        return static_cast<uint8_t>((prescale < 3.0f ? 3.0f : prescale > 255.0f ? 255.0f : prescale) + 0.5f);
+    }
+
+    // Length of one 4096-count PWM period at |prescale|, rounded to 1 us
+    static constexpr uint32_t period_us(uint8_t prescale)
+    {
+        return static_cast<uint32_t>((4096.0f * (prescale + 1) * 1000000.0f) / kOscillatorHz + 0.5f);
+    }
+
+    Pca9685(i2c_port_t port, uint8_t address, I2cPriority priority = I2cPriority::NORMAL);
+
+    // init() enables the ALLCALL address; |index| 1..3 selects SUBADR1..3
     bool init(float pwm_frequency_hz);
+    bool set_sub_address(uint8_t index, uint8_t address, bool enable = true);
+
     bool set_pwm(uint8_t channel, uint16_t on, uint16_t off);
     bool set_duty(uint8_t channel, uint16_t duty);
     bool set_all_off();
 
+    // Shadow register file: stage_* only edits the local copy of LEDn_ON/OFF,
+    // flush() writes the bytes that differ from what the chip currently holds
+    // as the fewest auto-increment bursts.
+    void stage_pwm(uint8_t channel, uint16_t on, uint16_t off);
+    void stage_duty(uint8_t channel, uint16_t duty);
+    void stage_off(uint8_t channel);
+    void stage_all_off();
+    bool flush();
+
+    // Bytes put on the wire by this instance (address + register + payload).
+    uint32_t bytes_written() const;
+
 private:
+    friend class Pca9685Group;
+
+    static constexpr size_t kRegisterFileSize = kChannelCount * 4;
+
     bool write_register(uint8_t reg, uint8_t value);
     bool write_registers(uint8_t reg, const uint8_t *data, size_t length);
+    size_t next_dirty(size_t from) const;
+    size_t next_burst(size_t from, size_t *end) const;
+
+    // Used by Pca9685Group around a broadcast ALL_LED write
+    void assume_blanked();
+    size_t pending_bursts(I2cWriteSegment *out, size_t max_count) const;
+    void mark_flushed(bool ok);
 
-    i2c_port_t port_;
-    uint8_t address_;
+    I2cDevice device_;
+    std::array<uint8_t, kRegisterFileSize> shadow_{};
+    std::array<uint8_t, kRegisterFileSize> chip_{};
+    bool chip_valid_ = false;
+    uint32_t bytes_written_ = 0;
+    uint8_t mode1_ = 0;
+};
+
+// Chips that answer a shared group address (ALLCALL or a sub-address).
+// Blanking goes out as one broadcast write, and the members' staged bursts
+// ride behind it in the same transaction using repeated STARTs.
+class Pca9685Group
+{
+public:
+    Pca9685Group(i2c_port_t port, uint8_t address = Pca9685::kAllCallAddress,
+                 I2cPriority priority = I2cPriority::NORMAL);
+
+    // Blank every member, then apply whatever is staged on top of the blank
+    // state. Staged full-off channels collapse into the broadcast, so usually
+    // only the lit channel follows it. Falls back to separate transfers when
+    // the bursts do not fit one command link.
+    bool blank_and_flush(Pca9685 *members, size_t count);
+
+    // Puts every member to sleep and restarts their PWM counters with one
+    // broadcast write, so they count in step again. Outputs stay dark for
+    // about one period plus 500 us. Members must have MODE1 as init() left
+    // it, i.e. no sub-addresses enabled.
+    bool restart_counters(uint32_t period_us);
+
+    uint32_t bytes_written() const;
+
+private:
+    I2cDevice device_;
+    uint32_t bytes_written_ = 0;
 };
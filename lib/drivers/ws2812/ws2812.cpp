@@ -2,42 +2,180 @@
 
 #include "esp_log.h"
 #include "esp_rom_gpio.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "sdkconfig.h"
+#include <algorithm>
+#include <new>
 #include <vector>
 
 namespace
 {
-constexpr uint32_t kRmtResolutionHz = 40000000; // 25ns resolution
-constexpr uint32_t kTicksPerMicrosecond = kRmtResolutionHz / 1000000;
+constexpr uint32_t kTicksPerMicrosecond = kWs2812RmtResolutionHz / 1000000;
 
 constexpr uint32_t kT0hTicks = (kTicksPerMicrosecond * 400) / 1000;
 constexpr uint32_t kT0lTicks = (kTicksPerMicrosecond * 850) / 1000;
 constexpr uint32_t kT1hTicks = (kTicksPerMicrosecond * 800) / 1000;
 constexpr uint32_t kT1lTicks = (kTicksPerMicrosecond * 450) / 1000;
+// Trailing low time that latches the frame, split over both symbol halves
+constexpr uint32_t kResetTicks = kTicksPerMicrosecond * 300;
+
+constexpr rmt_symbol_word_t make_symbol(uint32_t level0, uint32_t duration0, uint32_t level1, uint32_t duration1)
+{
+    rmt_symbol_word_t symbol{};
+    symbol.level0 = level0;
+    symbol.duration0 = duration0;
+    symbol.level1 = level1;
+    symbol.duration1 = duration1;
+    return symbol;
+}
 
 constexpr std::size_t kBytesPerPixel = 3;
-constexpr std::size_t kItemsPerLed = 24;
+// Only reached if the frame before last is still going out
+constexpr TickType_t kBufferWaitTicks = pdMS_TO_TICKS(100);
 
 const char *kTag = "ws2812";
+
+// Bytes encoder for the GRB payload, then a copy encoder for the reset
+// code. The RMT driver calls encode() again whenever its memory fills, so
+// no frame is ever expanded to symbols in RAM.
+struct Ws2812Encoder
+{
+    rmt_encoder_t base; // first, so the handle can be cast back
+    rmt_encoder_handle_t bytes_encoder;
+    rmt_encoder_handle_t copy_encoder;
+    bool sending_reset;
+};
+
+constexpr rmt_symbol_word_t kResetSymbol = make_symbol(0, kResetTicks / 2, 0, kResetTicks / 2);
+
+size_t ws2812_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
+                     const void *data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    auto *ws2812 = reinterpret_cast<Ws2812Encoder *>(encoder);
+    int state = RMT_ENCODING_RESET;
+    size_t encoded_symbols = 0;
+    rmt_encode_state_t session_state = RMT_ENCODING_RESET;
+
+    if (!ws2812->sending_reset)
+    {
+        encoded_symbols += ws2812->bytes_encoder->encode(ws2812->bytes_encoder, channel, data, data_size, &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE)
+        {
+            ws2812->sending_reset = true;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL)
+        {
+            *ret_state = static_cast<rmt_encode_state_t>(state | RMT_ENCODING_MEM_FULL);
+            return encoded_symbols;
+        }
+    }
+
+    encoded_symbols += ws2812->copy_encoder->encode(ws2812->copy_encoder, channel, &kResetSymbol,
+                                                    sizeof(kResetSymbol), &session_state);
+    if (session_state & RMT_ENCODING_COMPLETE)
+    {
+        ws2812->sending_reset = false;
+        state |= RMT_ENCODING_COMPLETE;
+    }
+    if (session_state & RMT_ENCODING_MEM_FULL)
+    {
+        state |= RMT_ENCODING_MEM_FULL;
+    }
+    *ret_state = static_cast<rmt_encode_state_t>(state);
+    return encoded_symbols;
+}
+
+esp_err_t ws2812_reset(rmt_encoder_t *encoder)
+{
+    auto *ws2812 = reinterpret_cast<Ws2812Encoder *>(encoder);
+    rmt_encoder_reset(ws2812->bytes_encoder);
+    rmt_encoder_reset(ws2812->copy_encoder);
+    ws2812->sending_reset = false;
+    return ESP_OK;
+}
+
+esp_err_t ws2812_del(rmt_encoder_t *encoder)
+{
+    auto *ws2812 = reinterpret_cast<Ws2812Encoder *>(encoder);
+    rmt_del_encoder(ws2812->bytes_encoder);
+    rmt_del_encoder(ws2812->copy_encoder);
+    delete ws2812;
+    return ESP_OK;
+}
 } // namespace
 
-Ws2812Strip::Ws2812Strip(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t copy_encoder, std::size_t led_count)
+esp_err_t Ws2812Strip::new_encoder(rmt_encoder_handle_t *out_encoder)
+{
+    if (!out_encoder)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    auto *ws2812 = new (std::nothrow) Ws2812Encoder{};
+    if (!ws2812)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    ws2812->base.encode = ws2812_encode;
+    ws2812->base.reset = ws2812_reset;
+    ws2812->base.del = ws2812_del;
+
+    rmt_bytes_encoder_config_t bytes_config = {};
+    bytes_config.bit0 = make_symbol(1, kT0hTicks, 0, kT0lTicks);
+    bytes_config.bit1 = make_symbol(1, kT1hTicks, 0, kT1lTicks);
+    bytes_config.flags.msb_first = 1;
+    esp_err_t status = rmt_new_bytes_encoder(&bytes_config, &ws2812->bytes_encoder);
+    if (status != ESP_OK)
+    {
+        delete ws2812;
+        return status;
+    }
+
+    rmt_copy_encoder_config_t copy_config = {};
+    status = rmt_new_copy_encoder(&copy_config, &ws2812->copy_encoder);
+    if (status != ESP_OK)
+    {
+        rmt_del_encoder(ws2812->bytes_encoder);
+        delete ws2812;
+        return status;
+    }
+
+    *out_encoder = &ws2812->base;
+    return ESP_OK;
+}
+
+Ws2812Strip::Ws2812Strip(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder,
+                         std::size_t led_count, std::size_t group_size)
     : led_count_(led_count),
+      group_size_(group_size),
       tx_channel_(tx_channel),
-      copy_encoder_(copy_encoder),
+      encoder_(encoder),
       pixel_buffer_()
 {
     if (led_count_ == 0)
     {
-#ifdef CONFIG_WS2812_LED_COUNT
-        led_count_ = CONFIG_WS2812_LED_COUNT;
-#else
         led_count_ = kTotalLedCount;
-#endif
+    }
+    if (group_size_ == 0)
+    {
+        group_size_ = kGroupSize;
     }
     pixel_buffer_.assign(led_count_ * kBytesPerPixel, 0);
+    for (auto &frame : frame_buffers_)
+    {
+        frame.assign(pixel_buffer_.size(), 0);
+    }
+
+    // Callbacks can only be registered on a disabled channel, so the strip
+    // enables it once they are in place
+    if (tx_channel_)
+    {
+        rmt_tx_event_callbacks_t callbacks = {};
+        callbacks.on_trans_done = on_trans_done;
+        ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(tx_channel_, &callbacks, this));
+        ESP_ERROR_CHECK(rmt_enable(tx_channel_));
+    }
     ESP_LOGI(kTag, "WS2812 initialized (total led_count=%zu)", led_count_);
 }
 
@@ -58,31 +196,56 @@ esp_err_t Ws2812Strip::set_pixel(std::size_t index, uint8_t red, uint8_t green,
         return ESP_ERR_INVALID_ARG;
     }
 
-    std::size_t offset = index * kBytesPerPixel;
-    pixel_buffer_[offset + 0] = red;
-    pixel_buffer_[offset + 1] = green;
-    pixel_buffer_[offset + 2] = blue;
+    write_pixel(index * kBytesPerPixel, red, green, blue);
     return ESP_OK;
 }
 
+void Ws2812Strip::write_pixel(std::size_t offset, uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint8_t *pixel = &pixel_buffer_[offset];
+    if (pixel[0] == green && pixel[1] == red && pixel[2] == blue)
+    {
+        return;
+    }
+    pixel[0] = green;
+    pixel[1] = red;
+    pixel[2] = blue;
+    dirty_ = true;
+}
+
 esp_err_t Ws2812Strip::set_group(std::size_t group_index, uint8_t red, uint8_t green, uint8_t blue)
 {
-    std::size_t first_led = group_index * kGroupSize;
-    if (first_led >= led_count_ || first_led + kGroupSize > led_count_)
+    std::size_t first_led = group_index * group_size_;
+    if (first_led >= led_count_ || first_led + group_size_ > led_count_)
     {
         return ESP_ERR_INVALID_ARG;
     }
-    for (std::size_t led = 0; led < kGroupSize; ++led)
+    for (std::size_t led = 0; led < group_size_; ++led)
     {
-        esp_err_t status = set_pixel(first_led + led, red, green, blue);
-        if (status != ESP_OK)
-        {
-            return status;
-        }
+        write_pixel((first_led + led) * kBytesPerPixel, red, green, blue);
     }
     return ESP_OK;
 }
 
+esp_err_t Ws2812Strip::set_pixels(std::size_t first, const uint8_t *red, const uint8_t *green,
+                                  const uint8_t *blue, std::size_t count)
+{
+    if (!red || !green || !blue || first >= led_count_ || count > led_count_ - first)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        write_pixel((first + i) * kBytesPerPixel, red[i], green[i], blue[i]);
+    }
+    return ESP_OK;
+}
+
+std::size_t Ws2812Strip::get_group_size() const
+{
+    return group_size_;
+}
+
 esp_err_t Ws2812Strip::fill(uint8_t red, uint8_t green, uint8_t blue)
 {
     if (pixel_buffer_.empty())
@@ -91,34 +254,40 @@ esp_err_t Ws2812Strip::fill(uint8_t red, uint8_t green, uint8_t blue)
     }
     for (std::size_t index = 0; index < led_count_; ++index)
     {
-        std::size_t offset = index * kBytesPerPixel;
-        pixel_buffer_[offset + 0] = red;
-        pixel_buffer_[offset + 1] = green;
-        pixel_buffer_[offset + 2] = blue;
+        write_pixel(index * kBytesPerPixel, red, green, blue);
     }
     return ESP_OK;
 }
 
 esp_err_t Ws2812Strip::show()
 {
-    if (!tx_channel_ || !copy_encoder_ || pixel_buffer_.empty())
+    if (!tx_channel_ || !encoder_ || pixel_buffer_.empty())
     {
         return ESP_ERR_INVALID_STATE;
     }
 
-    std::vector<rmt_symbol_word_t> symbols(led_count_ * kItemsPerLed);
-    for (std::size_t led = 0; led < led_count_; ++led)
+    const int64_t now_us = esp_timer_get_time();
+    const bool keepalive = !dirty_ && keepalive_us_ > 0 && now_us - last_transmit_us_ >= keepalive_us_;
+    if (!dirty_ && !keepalive)
+    {
+        skipped_frames_.fetch_add(1, std::memory_order_relaxed);
+        return ESP_OK;
+    }
+
+    const std::size_t buffer = next_buffer_;
+    if (buffer_busy_[buffer].load(std::memory_order_acquire))
     {
-        uint8_t red = pixel_buffer_[led * kBytesPerPixel + 0];
-        uint8_t green = pixel_buffer_[led * kBytesPerPixel + 1];
-        uint8_t blue = pixel_buffer_[led * kBytesPerPixel + 2];
-        uint8_t grb_bytes[3] = {green, red, blue};
-        for (std::size_t byte_index = 0; byte_index < 3; ++byte_index)
+        esp_err_t status = rmt_tx_wait_all_done(tx_channel_, kBufferWaitTicks);
+        if (status != ESP_OK)
         {
-            build_symbols_for_byte(&symbols[led * kItemsPerLed + byte_index * 8], grb_bytes[byte_index]);
+            ESP_LOGE(kTag, "rmt_tx_wait_all_done failed: %d", status);
+            return status;
         }
     }
 
+    std::vector<uint8_t> &frame = frame_buffers_[buffer];
+    std::copy(pixel_buffer_.begin(), pixel_buffer_.end(), frame.begin());
+
     rmt_transmit_config_t transmit_config = {
         .loop_count = 0,
         .flags = {
@@ -126,44 +295,77 @@ esp_err_t Ws2812Strip::show()
             .queue_nonblocking = 0,
         },
     };
-    esp_err_t status = rmt_transmit(tx_channel_, copy_encoder_, symbols.data(),
-                                    symbols.size() * sizeof(rmt_symbol_word_t), &transmit_config);
+    buffer_busy_[buffer].store(true, std::memory_order_release);
+    esp_err_t status = rmt_transmit(tx_channel_, encoder_, frame.data(), frame.size(), &transmit_config);
     if (status != ESP_OK)
     {
+        buffer_busy_[buffer].store(false, std::memory_order_release);
         ESP_LOGE(kTag, "rmt_transmit failed: %d", status);
         return status;
     }
-
-    status = rmt_tx_wait_all_done(tx_channel_, pdMS_TO_TICKS(100));
-    if (status != ESP_OK)
+    next_buffer_ = buffer ^ 1;
+    dirty_ = false;
+    last_transmit_us_ = now_us;
+    transmitted_frames_.fetch_add(1, std::memory_order_relaxed);
+    if (keepalive)
     {
-        ESP_LOGE(kTag, "rmt_tx_wait_all_done failed: %d", status);
-        return status;
+        keepalive_frames_.fetch_add(1, std::memory_order_relaxed);
     }
-
-    vTaskDelay(pdMS_TO_TICKS(1));
     return ESP_OK;
 }
 
+void Ws2812Strip::set_keepalive(uint32_t interval_ms)
+{
+    keepalive_us_ = static_cast<int64_t>(interval_ms) * 1000;
+}
+
+uint32_t Ws2812Strip::transmitted_frames() const
+{
+    return transmitted_frames_.load(std::memory_order_relaxed);
+}
+
+uint32_t Ws2812Strip::skipped_frames() const
+{
+    return skipped_frames_.load(std::memory_order_relaxed);
+}
+
+uint32_t Ws2812Strip::keepalive_frames() const
+{
+    return keepalive_frames_.load(std::memory_order_relaxed);
+}
+
+void Ws2812Strip::reset_frame_counters()
+{
+    transmitted_frames_.store(0, std::memory_order_relaxed);
+    skipped_frames_.store(0, std::memory_order_relaxed);
+    keepalive_frames_.store(0, std::memory_order_relaxed);
+}
+
+esp_err_t Ws2812Strip::wait_done(TickType_t timeout)
+{
+    if (!tx_channel_)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return rmt_tx_wait_all_done(tx_channel_, timeout);
+}
+
+void Ws2812Strip::set_done_callback(Ws2812DoneCallback callback, void *context)
+{
+    done_context_ = context;
+    done_callback_ = callback;
+}
 
-void Ws2812Strip::build_symbols_for_byte(rmt_symbol_word_t *symbols, uint8_t byte_value) const
+bool IRAM_ATTR Ws2812Strip::on_trans_done(rmt_channel_handle_t channel,
+                                          const rmt_tx_done_event_data_t *event,
+                                          void *user_ctx)
 {
-    for (int bit = 0; bit < 8; ++bit)
+    auto *strip = static_cast<Ws2812Strip *>(user_ctx);
+    strip->buffer_busy_[strip->done_buffer_].store(false, std::memory_order_release);
+    strip->done_buffer_ ^= 1;
+    if (strip->done_callback_)
     {
-        bool is_one = (byte_value & (1 << (7 - bit))) != 0;
-        if (is_one)
-        {
-            symbols[bit].level0 = 1;
-            symbols[bit].duration0 = kT1hTicks;
-            symbols[bit].level1 = 0;
-            symbols[bit].duration1 = kT1lTicks;
-        }
-        else
-        {
-            symbols[bit].level0 = 1;
-            symbols[bit].duration0 = kT0hTicks;
-            symbols[bit].level1 = 0;
-            symbols[bit].duration1 = kT0lTicks;
-        }
+        return strip->done_callback_(strip->done_context_);
     }
+    return false;
 }
@@ -5,10 +5,21 @@
 #include "driver/rmt_tx.h"
 #include "driver/rmt_encoder.h"
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
 
+// RMT tick rate the encoder's bit timings are computed for; the TX channel
+// must be created with it
+constexpr uint32_t kWs2812RmtResolutionHz = 40000000; // 25ns resolution
+
+// Runs in the RMT interrupt once a frame has left the wire; returns whether
+// it woke a higher priority task
+using Ws2812DoneCallback = bool (*)(void *context);
+
 class Ws2812Strip
 {
 public:
@@ -16,20 +27,68 @@ public:
     static constexpr std::size_t kGroupSize = 4;
     static constexpr std::size_t kGroupCount = kTotalLedCount / kGroupSize;
 
-    explicit Ws2812Strip(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t copy_encoder, std::size_t led_count = kTotalLedCount);
+    // Streams GRB bytes straight into RMT symbols as the channel needs
+    // them, then appends the reset code. Owned by the caller; free it with
+    // rmt_del_encoder.
+    static esp_err_t new_encoder(rmt_encoder_handle_t *out_encoder);
+
+    // group_size is the LEDs under one tube, for set_group()
+    explicit Ws2812Strip(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder,
+                         std::size_t led_count = kTotalLedCount, std::size_t group_size = kGroupSize);
     ~Ws2812Strip();
 
     std::size_t get_led_count() const;
     esp_err_t set_pixel(std::size_t index, uint8_t red, uint8_t green, uint8_t blue);
     esp_err_t set_group(std::size_t group_index, uint8_t red, uint8_t green, uint8_t blue);
+    // Writes count pixels from first, one plane per channel
+    esp_err_t set_pixels(std::size_t first, const uint8_t *red, const uint8_t *green, const uint8_t *blue,
+                         std::size_t count);
+    std::size_t get_group_size() const;
     esp_err_t fill(uint8_t red, uint8_t green, uint8_t blue);
+    // Copies the pixels into whichever frame buffer is idle and queues it,
+    // returning while the previous frame may still be on the wire. Does
+    // nothing if no pixel changed since the last frame sent, unless the
+    // keep-alive interval is up.
     esp_err_t show();
+    // Resend an unchanged frame after this long; 0 never resends
+    void set_keepalive(uint32_t interval_ms);
+    // Frames sent, frames skipped as unchanged, and how many of the sent
+    // ones were keep-alives
+    uint32_t transmitted_frames() const;
+    uint32_t skipped_frames() const;
+    uint32_t keepalive_frames() const;
+    void reset_frame_counters();
+    // Blocks until every queued frame is out
+    esp_err_t wait_done(TickType_t timeout);
+    void set_done_callback(Ws2812DoneCallback callback, void *context);
 
 private:
-    void build_symbols_for_byte(rmt_symbol_word_t *symbols, uint8_t byte_value) const;
+    void write_pixel(std::size_t offset, uint8_t red, uint8_t green, uint8_t blue);
+    static bool on_trans_done(rmt_channel_handle_t channel,
+                              const rmt_tx_done_event_data_t *event,
+                              void *user_ctx);
 
     std::size_t led_count_;
+    std::size_t group_size_;
     rmt_channel_handle_t tx_channel_;
-    rmt_encoder_handle_t copy_encoder_;
+    rmt_encoder_handle_t encoder_;
+    // GRB byte order, as the LEDs expect it on the wire
     std::vector<uint8_t> pixel_buffer_;
+    // Set when pixel_buffer_ differs from the last frame sent
+    bool dirty_ = true;
+    int64_t keepalive_us_ = 0;
+    int64_t last_transmit_us_ = 0;
+    std::atomic<uint32_t> transmitted_frames_{0};
+    std::atomic<uint32_t> skipped_frames_{0};
+    std::atomic<uint32_t> keepalive_frames_{0};
+
+    // Two persistent copies of pixel_buffer_, so the next frame can be
+    // drawn while the encoder still reads the last one. Frames complete in
+    // order, so the ISR frees them alternately starting from the first.
+    std::array<std::vector<uint8_t>, 2> frame_buffers_;
+    std::atomic<bool> buffer_busy_[2] = {};
+    std::size_t next_buffer_ = 0;
+    std::size_t done_buffer_ = 0;
+    Ws2812DoneCallback done_callback_ = nullptr;
+    void *done_context_ = nullptr;
 };
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// PCA9685 chip (index into the profile's address list) and output channel
+// that sink one cathode
+struct NixieChannel
+{
+    uint8_t chip_index;
+    uint8_t channel;
+};
+
+// Everything that differs between display boards. Profiles are constexpr,
+// so the driver's tables fold to constants and nothing is built at boot.
+template <size_t TubeCount, size_t PcaCount, size_t LedsPerTube>
+struct BoardProfile
+{
+    static constexpr size_t kTubeCount = TubeCount;
+    static constexpr size_t kPcaCount = PcaCount;
+    static constexpr size_t kLedsPerTube = LedsPerTube;
+    static constexpr size_t kLedCount = TubeCount * LedsPerTube;
+
+    std::array<uint8_t, PcaCount> pca_addresses;
+    // Cathode of each tube, by numeral
+    std::array<std::array<NixieChannel, 10>, TubeCount> tube_map;
+};
+
+// Cathodes packed in order over pairs of chips: three tubes take 30 of a
+// pair's 32 channels, so the middle tube straddles the chip boundary.
+template <size_t TubeCount>
+constexpr std::array<std::array<NixieChannel, 10>, TubeCount> paired_chip_tube_map()
+{
+    std::array<std::array<NixieChannel, 10>, TubeCount> map{};
+    for (size_t tube = 0; tube < TubeCount; ++tube) {
+        for (size_t numeral = 0; numeral < 10; ++numeral) {
+            const size_t index = (tube % 3) * 10 + numeral;
+            map[tube][numeral] = NixieChannel{static_cast<uint8_t>((tube / 3) * 2 + index / 16),
+                                              static_cast<uint8_t>(index % 16)};
+        }
+    }
+    return map;
+}
+
+template <typename Profile>
+constexpr bool tube_map_fits(const Profile &profile)
+{
+    for (const auto &tube : profile.tube_map) {
+        for (const NixieChannel &cathode : tube) {
+            if (cathode.chip_index >= Profile::kPcaCount || cathode.channel >= 16) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// hardware/display_board_in4: 6x IN-4, 4x PCA9685 at 0x40-0x43 and
+// four WS2812B-2020 backlight LEDs under each tube
+using In4Board = BoardProfile<6, 4, 4>;
+inline constexpr In4Board kIn4Board = {
+    {0x40, 0x41, 0x42, 0x43},
+    paired_chip_tube_map<6>(),
+};
+
+// hardware/display_board_in18 is still being laid out; until its schematic
+// exists it keeps the IN-4 chip chain and backlight layout
+using In18Board = BoardProfile<6, 4, 4>;
+inline constexpr In18Board kIn18Board = {
+    {0x40, 0x41, 0x42, 0x43},
+    paired_chip_tube_map<6>(),
+};
+
+#if defined(CONFIG_NIXIE_BOARD_IN18)
+using Board = In18Board;
+inline constexpr const Board &kBoard = kIn18Board;
+#else
+using Board = In4Board;
+inline constexpr const Board &kBoard = kIn4Board;
+#endif
+
+constexpr size_t kNixieTubeCount = Board::kTubeCount;
+constexpr size_t kNixiePcaCount = Board::kPcaCount;
+constexpr size_t kBacklightLedsPerTube = Board::kLedsPerTube;
+constexpr size_t kBacklightLedCount = Board::kLedCount;
+
+static_assert(tube_map_fits(kBoard), "Board tube map points past its PCA9685 chips");
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <span>
 
 struct RgbColor
 {
@@ -16,6 +19,82 @@ struct HsvColor
     uint8_t value; // 0-255
 };
 
+// Struct-of-arrays pixel planes: one contiguous array per channel, so a
+// batch pass streams each plane linearly instead of hopping through structs
+struct HsvPlanes
+{
+    std::span<const uint16_t> hue;
+    std::span<const uint8_t> saturation;
+    std::span<const uint8_t> value;
+};
+
+struct RgbPlanes
+{
+    std::span<uint8_t> red;
+    std::span<uint8_t> green;
+    std::span<uint8_t> blue;
+};
+
+template <std::size_t N>
+struct HsvFrame
+{
+    std::array<uint16_t, N> hue{};
+    std::array<uint8_t, N> saturation{};
+    std::array<uint8_t, N> value{};
+
+    HsvPlanes planes() const
+    {
+        return {hue, saturation, value};
+    }
+};
+
+template <std::size_t N>
+struct RgbFrame
+{
+    std::array<uint8_t, N> red{};
+    std::array<uint8_t, N> green{};
+    std::array<uint8_t, N> blue{};
+
+    RgbPlanes planes()
+    {
+        return {red, green, blue};
+    }
+};
+
+// Gamma-corrected drive level in 8.8 fixed point, so 0xFF00 is full on.
+// The fraction is what temporal dithering turns into extra levels.
+constexpr uint16_t kColor16Max = 0xFF00;
+
+struct RgbPlanes16
+{
+    std::span<uint16_t> red;
+    std::span<uint16_t> green;
+    std::span<uint16_t> blue;
+};
+
+template <std::size_t N>
+struct RgbFrame16
+{
+    std::array<uint16_t, N> red{};
+    std::array<uint16_t, N> green{};
+    std::array<uint16_t, N> blue{};
+
+    RgbPlanes16 planes()
+    {
+        return {red, green, blue};
+    }
+};
+
 RgbColor hsv_to_rgb(const HsvColor &hsv);
+// Integer version: hue-sector lookup and 8.8 fixed point, no float. Within
+// kHsvFixedMaxError of hsv_to_rgb on every channel.
+RgbColor hsv_to_rgb_fixed(const HsvColor &hsv);
+constexpr uint8_t kHsvFixedMaxError = 1;
 HsvColor rgb_to_hsv(const RgbColor &rgb);
 RgbColor apply_gamma(const RgbColor &linear_color);
+// hsv_to_rgb_fixed then apply_gamma over the shortest plane, in one pass
+void hsv_to_rgb_gamma(const HsvPlanes &in, const RgbPlanes &out);
+// apply_gamma for one channel, keeping 8 fractional bits
+uint16_t gamma16(uint8_t level);
+// hsv_to_rgb_gamma with 8.8 output
+void hsv_to_rgb_gamma16(const HsvPlanes &in, const RgbPlanes16 &out);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Single-writer, single-reader double buffer for small POD frames.
+// publish() fills the back buffer and flips it to the front by bumping the
+// sequence; read() copies the front and retries if the writer started on
+// that buffer meanwhile. Neither side ever blocks, so it is safe between a
+// normal task and the scan task without a mutex.
+template <typename Frame>
+class FrameBuffer
+{
+public:
+    explicit FrameBuffer(const Frame &initial = Frame{})
+    {
+        buffers_[0] = initial;
+        buffers_[1] = initial;
+    }
+
+    void publish(const Frame &frame)
+    {
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        // The back buffer was the front until the last bump. That bump is
+        // what tells a reader still copying it to retry, so it has to be
+        // visible before any of the writes below; pairs with the acquire
+        // fence in read().
+        std::atomic_thread_fence(std::memory_order_release);
+        buffers_[(sequence + 1) & 1] = frame;
+        sequence_.store(sequence + 1, std::memory_order_release);
+    }
+
+    // Returns the sequence of the copied frame
+    uint32_t read(Frame &out) const
+    {
+        while (true) {
+            const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+            out = buffers_[sequence & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // One more publish means the writer may now be refilling the
+            // buffer we just copied, so only an unchanged sequence is clean
+            if (sequence_.load(std::memory_order_relaxed) == sequence) {
+                return sequence;
+            }
+        }
+    }
+
+    uint32_t sequence() const
+    {
+        return sequence_.load(std::memory_order_acquire);
+    }
+
+private:
+    Frame buffers_[2];
+    std::atomic<uint32_t> sequence_{0};
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "board_profile.h"
+#include "hv57708/hv57708_bitstream.h"
+
+static_assert(kNixieTubeCount * 10 <= Hv57708Bitstream::kOutputCount, "One HV57708 output per cathode");
+
+// HVOUT index (0-based) of each tube's cathodes, by numeral: ten outputs per
+// tube, left to right
+constexpr std::array<std::array<uint8_t, 10>, kNixieTubeCount> make_hv57708_digit_map()
+{
+    std::array<std::array<uint8_t, 10>, kNixieTubeCount> map{};
+    for (size_t tube = 0; tube < kNixieTubeCount; ++tube) {
+        for (size_t numeral = 0; numeral < 10; ++numeral) {
+            map[tube][numeral] = static_cast<uint8_t>(tube * 10 + numeral);
+        }
+    }
+    return map;
+}
+
+inline constexpr std::array<std::array<uint8_t, 10>, kNixieTubeCount> kHv57708DigitMap =
+    make_hv57708_digit_map();
+
+// Output word for a set of digits; numerals above 9 leave the tube blank
+inline uint64_t hv57708_digit_outputs(const std::array<uint8_t, kNixieTubeCount> &digits)
+{
+    uint64_t outputs = 0;
+    for (size_t tube = 0; tube < kHv57708DigitMap.size(); ++tube) {
+        if (digits[tube] < 10) {
+            outputs |= 1ULL << kHv57708DigitMap[tube][digits[tube]];
+        }
+    }
+    return outputs;
+}
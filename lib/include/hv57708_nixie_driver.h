@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "nixie_driver.h"
+#include "hv57708/hv57708.h"
+#include "hv57708_digit_map.h"
+
+// Static (non-multiplexed) backend: every cathode has its own HV57708 output,
+// so each tube is lit 100% of the time and no scan task is needed. A frame
+// update is one 16-clock SPI transfer plus a latch pulse.
+class Hv57708NixieDriver : public INixieDriver
+{
+public:
+    Hv57708NixieDriver();
+    ~Hv57708NixieDriver() override = default;
+
+    void display_time(uint8_t h, uint8_t m, uint8_t s) override;
+    void display_number(uint32_t number) override;
+    void set_brightness(uint8_t brightness) override;
+    void set_digits(const NixieDigits &digits) override;
+    // Brings up SPI and the BL dimming; the I2C port is not used
+    void nixie_scan_start(i2c_port_t i2c_port) override;
+    std::vector<NixieTube *> get_tubes() override;
+    NixieScanStats get_scan_stats() const override;
+    void reset_scan_stats() override;
+    // Ignored: without a scan there is no slot to share, digits switch instantly
+    void set_transition(NixieTransition transition, uint16_t duration_ms) override;
+    // Stored only: the outputs are on/off and BL dims every cathode at once
+    void set_calibration(const NixieCalibration &calibration) override;
+    NixieCalibration get_calibration() const override;
+    NixieWear get_wear() const override;
+    bool restore_wear(const NixieWear &wear) override;
+
+private:
+    void write_frame();
+    // Credits the time since the last call to the digits on show; needs wear_lock_
+    void account_wear() const;
+
+    Hv57708 chip_;
+    std::array<NixieTube, kNixieTubeCount> tubes_;
+    NixieDigits digit_cache_{};
+    uint8_t brightness_ = 128;
+    bool ready_ = false;
+    NixieScanStats stats_{};
+    mutable portMUX_TYPE calibration_lock_ = portMUX_INITIALIZER_UNLOCKED;
+    NixieCalibration calibration_ = uniform_nixie_calibration();
+    // There is no scan task, so on-time is credited whenever the digits or
+    // the brightness change, and on every read
+    mutable portMUX_TYPE wear_lock_ = portMUX_INITIALIZER_UNLOCKED;
+    mutable NixieWearCounter wear_counter_;
+    mutable int64_t wear_last_us_ = 0;
+};
@@ -14,6 +14,15 @@ struct BackLightState
     uint8_t brightness;
 };
 
+// show() calls since the last reset: frames sent to the strip, frames
+// skipped because no pixel changed, and sent frames that were keep-alives
+struct LedShowStats
+{
+    uint32_t transmitted;
+    uint32_t skipped;
+    uint32_t keepalive;
+};
+
 // Abstract Interface for LED Driver
 class ILedDriver
 {
@@ -23,7 +32,14 @@ public:
     // Core LED control methods (formerly in ILedStrip)
     virtual std::size_t get_led_count() const = 0;
     virtual esp_err_t set_pixel(std::size_t index, uint8_t red, uint8_t green, uint8_t blue) = 0;
+    // Bulk writes: every LED of one tube, or count LEDs from plane arrays
+    virtual esp_err_t set_group(std::size_t tube, uint8_t red, uint8_t green, uint8_t blue) = 0;
+    virtual esp_err_t set_pixels(std::size_t first, const uint8_t *red, const uint8_t *green,
+                                 const uint8_t *blue, std::size_t count) = 0;
+    // Only transmits when a pixel changed, or as a keep-alive refresh
     virtual esp_err_t show() = 0;
+    virtual LedShowStats get_show_stats() const = 0;
+    virtual void reset_show_stats() = 0;
     
     // Additional helper methods
     virtual esp_err_t fill(uint8_t red, uint8_t green, uint8_t blue) = 0;
@@ -37,12 +53,17 @@ class Ws2812Strip;
 class LedDriver : public ILedDriver
 {
 public:
-    explicit LedDriver(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t copy_encoder);
+    explicit LedDriver(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder);
     ~LedDriver() override;
 
     std::size_t get_led_count() const override;
     esp_err_t set_pixel(std::size_t index, uint8_t red, uint8_t green, uint8_t blue) override;
+    esp_err_t set_group(std::size_t tube, uint8_t red, uint8_t green, uint8_t blue) override;
+    esp_err_t set_pixels(std::size_t first, const uint8_t *red, const uint8_t *green,
+                         const uint8_t *blue, std::size_t count) override;
     esp_err_t show() override;
+    LedShowStats get_show_stats() const override;
+    void reset_show_stats() override;
     esp_err_t fill(uint8_t red, uint8_t green, uint8_t blue) override;
     esp_err_t clear() override;
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "color_model.h"
@@ -31,19 +33,7 @@ struct AudioMessage
     } param;
 };
 
-// --- Display Daemon Messages ---
-enum class DisplayCmd : uint8_t
-{
-    UPDATE_TIME,
-    SET_MODE,
-    SET_MANUAL_NUMBER,
-    SET_BACKLIGHT_COLOR,
-    SET_BACKLIGHT_BRIGHTNESS,
-    SET_EFFECT,
-    ENABLE_EFFECT,
-    UPDATE_BATTERY
-};
-
+// --- Display Daemon State (see DisplayState) ---
 enum class DisplayMode : uint8_t
 {
     CLOCK_HHMMSS,
@@ -53,28 +43,6 @@ enum class DisplayMode : uint8_t
     OFF
 };
 
-struct DisplayMessage
-{
-    DisplayCmd command;
-    union
-    {
-        struct
-        {
-            uint8_t h, m, s;
-        } time;
-        DisplayMode mode;
-        uint32_t number;
-        struct
-        {
-            uint8_t r, g, b;
-        } color;
-        HsvColor hsv;
-        uint8_t brightness;
-        uint8_t effect_id; // 0: None, 1: Breath, 2: Rainbow, etc.
-        GasgaugeData battery;
-    } data;
-};
-
 // --- System Controller Messages (Input from other tasks/ISRs) ---
 enum class SystemEvent : uint8_t
 {
@@ -88,10 +56,14 @@ enum class SystemEvent : uint8_t
     POWER_UPDATE
 };
 
+constexpr size_t kSystemEventCount = static_cast<size_t>(SystemEvent::POWER_UPDATE) + 1;
+
 enum class CliCommandType : uint8_t
 {
     SET_NIXIE,
-    SET_BACKLIGHT
+    SET_BACKLIGHT,
+    SET_TRANSITION,
+    SET_EFFECT
 };
 
 struct CliData
@@ -103,12 +75,19 @@ struct CliData
         uint8_t brightness;
         bool has_color;
         bool has_brightness;
+        uint8_t tube; // 1-based, 0 for every tube
     } backlight;
+    uint8_t effect_id; // For SET_EFFECT, as DisplayStateData::effect_id
+    struct {
+        uint8_t type; // NixieTransition
+        uint16_t duration_ms;
+    } transition;
 };
 
 struct SystemMessage
 {
     SystemEvent event;
+    int64_t enqueued_us; // stamped by post_system_message
     union
     {
         uint8_t button_id;
@@ -118,4 +97,11 @@ struct SystemMessage
         // TODO: Add other features
         // Add other event data as needed
     } data;
-};
\ No newline at end of file
+};
+
+// Sends msg to the SystemController queue, stamped for its latency stats
+inline BaseType_t post_system_message(QueueHandle_t queue, SystemMessage &msg, TickType_t wait = 0)
+{
+    msg.enqueued_us = esp_timer_get_time();
+    return xQueueSend(queue, &msg, wait);
+}
@@ -3,10 +3,56 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include <atomic>
 #include "nixie_tube.h"
+#include "frame_buffer.h"
 #include "pca9685/pca9685.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "driver/gptimer.h"
+
+enum class NixieScanMode : uint8_t
+{
+    SEQUENTIAL, // scan task lights one tube per step
+    STAGGERED   // each tube owns a PCA9685 phase window, bus idle in steady state
+};
+
+enum class NixieTransition : uint8_t
+{
+    NONE,      // switch instantly
+    CROSSFADE, // old and new cathode split the tube's PWM period on opposite ramps
+    SLOT_ROLL, // changed tubes count up through the numerals in between
+    SCROLL     // the old reading slides out, the new one slides in
+};
+
+// Everything the scan needs for one multiplex frame
+struct NixieFrame
+{
+    NixieDigits digits;
+    uint8_t brightness;
+    NixieTransition transition; // played when the digits change
+    uint16_t transition_ms;
+};
+
+// Upper bounds of the slot-start error bins; the last bin is open-ended
+constexpr std::array<uint32_t, 6> kNixieSlotErrorBinsUs = {25, 50, 100, 200, 500, 1000};
+
+// I2C traffic and heap use of the scan task, sampled once per multiplex frame,
+// plus how late the task started each timer slot in sequential mode
+struct NixieScanStats
+{
+    uint32_t frames;
+    uint32_t last_frame_bytes;
+    uint32_t max_frame_bytes;
+    uint32_t last_frame_allocations; // needs CONFIG_HEAP_USE_HOOKS
+    uint32_t slots;
+    uint32_t missed_slots;
+    uint32_t max_slot_error_us;
+    std::array<uint32_t, kNixieSlotErrorBinsUs.size() + 1> slot_error_histogram;
+};
+
+// display_time() writes HH MM SS to the first six tubes
+static_assert(kNixieTubeCount >= 6, "display_time needs six tubes");
 
 // Abstract Interface for Nixie Driver
 class INixieDriver
@@ -15,10 +61,20 @@ public:
     virtual ~INixieDriver() = default;
     virtual void display_time(uint8_t h, uint8_t m, uint8_t s) = 0;
     virtual void display_number(uint32_t number) = 0;
-    virtual void set_brightness(uint8_t brightness) = 0; // PWM or similar if supported
-    virtual void set_digits(const std::array<uint8_t, 6> &digits) = 0;
+    virtual void set_brightness(uint8_t brightness) = 0; // OE PWM or PCA duty, see NIXIE_OE_PWM_DIMMING
+    virtual void set_digits(const NixieDigits &digits) = 0;
     virtual void nixie_scan_start(i2c_port_t i2c_port) = 0;
     virtual std::vector<NixieTube *> get_tubes() = 0;
+    virtual NixieScanStats get_scan_stats() const = 0;
+    virtual void reset_scan_stats() = 0;
+    virtual void set_transition(NixieTransition transition, uint16_t duration_ms) = 0;
+    // Safe to call from any task
+    virtual void set_calibration(const NixieCalibration &calibration) = 0;
+    virtual NixieCalibration get_calibration() const = 0;
+    // Safe to call from any task; refreshed about once a second
+    virtual NixieWear get_wear() const = 0;
+    // Seeds the counters from NVS, so only before nixie_scan_start
+    virtual bool restore_wear(const NixieWear &wear) = 0;
 };
 
 // Concrete Implementation
@@ -31,21 +87,109 @@ public:
     void display_time(uint8_t h, uint8_t m, uint8_t s) override;
     void display_number(uint32_t number) override;
     void set_brightness(uint8_t brightness) override;
-    void set_digits(const std::array<uint8_t, 6> &digits) override;
+    void set_digits(const NixieDigits &digits) override;
     void nixie_scan_start(i2c_port_t i2c_port) override;
     std::vector<NixieTube *> get_tubes() override;
+    NixieScanStats get_scan_stats() const override;
+    void reset_scan_stats() override;
+    void set_transition(NixieTransition transition, uint16_t duration_ms) override;
+    void set_calibration(const NixieCalibration &calibration) override;
+    NixieCalibration get_calibration() const override;
+    NixieWear get_wear() const override;
+    bool restore_wear(const NixieWear &wear) override;
+    void set_scan_mode(NixieScanMode mode);
 
 private:
+    // Transitions advance once per multiplex frame, up to one second
+    static constexpr size_t kMaxTransitionFrames = 100;
+    static constexpr uint8_t kNoNumeral = 0xFF;
+
+    // What one tube's slot lights for the current frame: a numeral from
+    // counter 0, and while crossfading a second one right after it
+    struct TubePlan
+    {
+        uint8_t numeral;
+        uint16_t off;
+        uint8_t fade_numeral;
+        uint16_t fade_on;
+        uint16_t fade_off;
+    };
+
     static void scan_task_entry(void *param);
+    static bool on_slot_alarm(gptimer_handle_t timer,
+                              const gptimer_alarm_event_data_t *event,
+                              void *user_ctx);
+    bool create_slot_timer();
     void scan_loop();
-    void apply_tube_output(std::array<Pca9685, 4> &pca,
-                           size_t tube_index,
-                           uint8_t numeral,
-                           uint16_t duty);
-
-    std::array<NixieTube, 6> tubes_;
-    std::array<uint8_t, 6> digit_cache_{};
-    uint8_t brightness_ = 0;
+    void stage_tube_plan(std::array<Pca9685, kNixiePcaCount> &pca, size_t tube_index);
+    void start_transition(const NixieDigits &from);
+    void plan_frame();
+    void program_staggered_frame(std::array<Pca9685, kNixiePcaCount> &pca);
+    void record_frame_bytes(const std::array<Pca9685, kNixiePcaCount> &pca, const Pca9685Group &group);
+    void record_slot_timing(uint32_t start_us, uint32_t missed);
+    void request_refresh();
+    void publish_digits();
+    bool latch_frame();
+    void rebuild_duty_table();
+    void account_wear();
+    bool init_oe_dimming();
+    void apply_oe_brightness(uint8_t brightness);
+    uint8_t pca_brightness() const;
+
+    std::array<NixieTube, kNixieTubeCount> tubes_;
+    // Composed by the display task, handed to the scan task whole through
+    // frames_ and only picked up there at frame boundaries
+    NixieFrame pending_;
+    FrameBuffer<NixieFrame> frames_;
+    NixieFrame scan_frame_;
+    uint32_t scan_frame_sequence_ = 0;
+
+    // Calibration may come from the CLI or the web task, so its writers
+    // serialise on a lock; the scan task still reads it lock-free.
+    mutable portMUX_TYPE calibration_lock_ = portMUX_INITIALIZER_UNLOCKED;
+    NixieCalibration calibration_pending_;
+    FrameBuffer<NixieCalibration> calibration_;
+    uint32_t calibration_sequence_ = 0;
+    // 12-bit PCA duty per tube and numeral: calibration x brightness, built
+    // by the scan task whenever either changes
+    std::array<std::array<uint16_t, 10>, kNixieTubeCount> duty_table_{};
+
+    // Transition state, owned by the scan task. ramp_ holds a smoothstep
+    // 0..4096 per frame and is only rebuilt when the duration changes, so
+    // planning a frame is a lookup plus one scale per tube.
+    std::array<TubePlan, kNixieTubeCount> plans_{};
+    NixieDigits transition_from_{};
+    uint8_t transition_mask_ = 0;
+    NixieTransition active_transition_ = NixieTransition::NONE;
+    uint16_t transition_step_ = 0;
+    uint16_t transition_frames_ = 0;
+    uint16_t ramp_duration_ms_ = 0;
+    std::array<uint16_t, kMaxTransitionFrames> ramp_{};
+
+    // Cathode on-time, counted by the scan task from the plans it lights
+    // and published once a second for readers in other tasks
+    NixieWearCounter wear_counter_;
+    FrameBuffer<NixieWear> wear_;
+    int64_t wear_last_us_ = 0;
+    uint32_t wear_publish_ms_ = 0;
+    // Last time the staggered mode restarted the PWM counters together
+    int64_t staggered_resync_us_ = 0;
+    // Set once the OE pin runs from LEDC; the PCA duty then stays at full
+    std::atomic<bool> oe_dimming_{false};
     TaskHandle_t scan_task_ = nullptr;
     i2c_port_t i2c_port_ = I2C_NUM_0;
+    NixieScanMode scan_mode_;
+    // Counted by the scan task and published once a frame, so a reader
+    // never sees a half-updated histogram
+    NixieScanStats scan_stats_{};
+    FrameBuffer<NixieScanStats> scan_stats_published_;
+    uint32_t frame_start_bytes_ = 0;
+    int heap_slot_ = -1;
+    uint32_t frame_start_allocations_ = 0;
+    std::atomic<bool> stats_reset_requested_{false};
+
+    // Slot timer: the alarm ISR stamps the slot start and wakes the scan task
+    gptimer_handle_t slot_timer_ = nullptr;
+    std::atomic<uint32_t> slot_sequence_{0};
+    std::atomic<uint32_t> slot_start_us_{0};
 };
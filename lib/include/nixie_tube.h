@@ -1,7 +1,12 @@
 #pragma once
 
 #include "freertos/FreeRTOS.h"
+#include <array>
 #include <cstdint>
+#include "board_profile.h"
+
+// One numeral per tube, left to right; above 9 leaves the tube blank
+using NixieDigits = std::array<uint8_t, kNixieTubeCount>;
 
 struct DigitState
 {
@@ -9,6 +14,59 @@ struct DigitState
     uint8_t nixie_brightness;
 };
 
+// Relative drive level per tube and numeral, 255 = full. Drivers fold it
+// into precomputed duty tables, so it costs nothing per scan step.
+using NixieCalibration = std::array<std::array<uint8_t, 10>, kNixieTubeCount>;
+
+inline NixieCalibration uniform_nixie_calibration(uint8_t level = 255)
+{
+    NixieCalibration calibration;
+    for (auto &tube : calibration) {
+        tube.fill(level);
+    }
+    return calibration;
+}
+
+// 12-bit PWM duty for a cathode: brightness x calibration, both 0..255.
+// Only a linear dimmer if the tube sees whole PWM periods, which is why the
+// sequential scan gives each slot exactly one.
+constexpr uint16_t nixie_cathode_duty(uint8_t level, uint8_t calibration)
+{
+    return static_cast<uint16_t>((static_cast<uint32_t>(level) * calibration * 4095) / (255 * 255));
+}
+
+// Seconds each cathode has been selected, per tube and numeral. Clock use
+// leaves some cathodes dark for years, which is what poisons them.
+using NixieWear = std::array<std::array<uint32_t, 10>, kNixieTubeCount>;
+
+// Adds short on-time intervals in milliseconds and carries whole seconds
+// into a NixieWear, so the counters survive being sampled every frame
+class NixieWearCounter
+{
+public:
+    void add(size_t tube, uint8_t numeral, uint32_t elapsed_ms)
+    {
+        const uint32_t total = remainder_ms_[tube][numeral] + elapsed_ms;
+        seconds_[tube][numeral] += total / 1000;
+        remainder_ms_[tube][numeral] = static_cast<uint16_t>(total % 1000);
+    }
+
+    void restore(const NixieWear &seconds)
+    {
+        seconds_ = seconds;
+        remainder_ms_ = {};
+    }
+
+    const NixieWear &seconds() const
+    {
+        return seconds_;
+    }
+
+private:
+    NixieWear seconds_{};
+    std::array<std::array<uint16_t, 10>, kNixieTubeCount> remainder_ms_{};
+};
+
 class NixieTube
 {
 public:
@@ -0,0 +1,131 @@
+#include "cathode_care.h"
+#include "esp_log.h"
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+const char *kTag = "CathodeCare";
+
+// NVS pages take ~100k erases; an hourly blob write loses at most an hour of
+// counting on power loss and is nowhere near that budget
+constexpr uint32_t kSaveIntervalMs = 60 * 60 * 1000;
+
+constexpr uint32_t kRoutineIntervalMs = CONFIG_NIXIE_CARE_INTERVAL_MIN * 60 * 1000;
+constexpr uint32_t kRoutineDurationMs = CONFIG_NIXIE_CARE_DURATION_S * 1000;
+constexpr uint32_t kStepMs = 250;
+// Each routine only visits the least-used few, so they get most of the time
+constexpr size_t kCycledNumerals = 4;
+
+uint64_t total_seconds(const NixieWear &wear)
+{
+    uint64_t total = 0;
+    for (const auto &tube : wear) {
+        total = std::accumulate(tube.begin(), tube.end(), total);
+    }
+    return total;
+}
+} // namespace
+
+CathodeCare::CathodeCare(INixieDriver &nixie_driver, SettingsStore &settings_store)
+    : nixie_driver_(nixie_driver), settings_store_(settings_store)
+{
+}
+
+bool CathodeCare::restore()
+{
+    NixieWear wear;
+    if (!settings_store_.load_wear(&wear)) {
+        ESP_LOGW(kTag, "Failed to load cathode wear, starting from zero");
+        return false;
+    }
+    saved_total_s_ = total_seconds(wear);
+    return nixie_driver_.restore_wear(wear);
+}
+
+bool CathodeCare::save()
+{
+    const NixieWear wear = nixie_driver_.get_wear();
+    const uint64_t total = total_seconds(wear);
+    if (total == saved_total_s_) {
+        return true;
+    }
+    if (!settings_store_.save_wear(wear)) {
+        ESP_LOGW(kTag, "Failed to save cathode wear");
+        return false;
+    }
+    saved_total_s_ = total;
+    return true;
+}
+
+bool CathodeCare::active() const
+{
+    return active_;
+}
+
+bool CathodeCare::in_off_hours(int hour)
+{
+    constexpr int start = CONFIG_NIXIE_CARE_START_HOUR;
+    constexpr int end = CONFIG_NIXIE_CARE_END_HOUR;
+    if (hour < 0 || start == end) {
+        return false;
+    }
+    if (start < end) {
+        return hour >= start && hour < end;
+    }
+    return hour >= start || hour < end; // window wraps past midnight
+}
+
+void CathodeCare::start_routine(uint32_t now_ms)
+{
+    const NixieWear wear = nixie_driver_.get_wear();
+    for (size_t tube = 0; tube < order_.size(); ++tube) {
+        std::iota(order_[tube].begin(), order_[tube].end(), 0);
+        std::stable_sort(order_[tube].begin(), order_[tube].end(),
+                         [&](uint8_t a, uint8_t b) { return wear[tube][a] < wear[tube][b]; });
+    }
+    active_ = true;
+    has_run_ = true;
+    routine_start_ms_ = now_ms;
+    shown_step_ = UINT32_MAX;
+    ESP_LOGI(kTag, "Cycling least-used cathodes for %lu s", kRoutineDurationMs / 1000);
+}
+
+bool CathodeCare::update(uint32_t now_ms, int hour)
+{
+    if (now_ms - last_save_ms_ >= kSaveIntervalMs) {
+        last_save_ms_ = now_ms;
+        save();
+    }
+
+    if (!in_off_hours(hour)) {
+        active_ = false;
+        return false;
+    }
+
+    if (!active_) {
+        // Rate limit: one routine per interval, the first as soon as the
+        // window opens
+        if (has_run_ && now_ms - routine_start_ms_ < kRoutineIntervalMs) {
+            return false;
+        }
+        start_routine(now_ms);
+    }
+
+    const uint32_t elapsed_ms = now_ms - routine_start_ms_;
+    if (elapsed_ms >= kRoutineDurationMs) {
+        active_ = false;
+        return false;
+    }
+
+    const uint32_t step = elapsed_ms / kStepMs;
+    if (step != shown_step_) {
+        shown_step_ = step;
+        NixieDigits digits;
+        for (size_t tube = 0; tube < digits.size(); ++tube) {
+            digits[tube] = order_[tube][step % kCycledNumerals];
+        }
+        nixie_driver_.set_digits(digits);
+    }
+    return true;
+}
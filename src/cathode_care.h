@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "nixie_driver.h"
+#include "settings_store.h"
+
+// Cathode-poisoning care. Persists the driver's per-cathode on-time and,
+// during the configured off-hours, runs short routines that cycle every
+// tube through its least-used numerals. Driven by the display task; there
+// is no task of its own.
+class CathodeCare
+{
+public:
+    CathodeCare(INixieDriver &nixie_driver, SettingsStore &settings_store);
+
+    // Loads the counters into the driver, so only before nixie_scan_start
+    bool restore();
+    // Call every display frame with the hour on show, or -1 when the tubes
+    // are not showing the clock. Returns true while a routine owns the tubes.
+    bool update(uint32_t now_ms, int hour);
+    bool active() const;
+    // Writes the counters if they moved since the last save
+    bool save();
+
+private:
+    static bool in_off_hours(int hour);
+    void start_routine(uint32_t now_ms);
+
+    INixieDriver &nixie_driver_;
+    SettingsStore &settings_store_;
+
+    uint64_t saved_total_s_ = 0;
+    uint32_t last_save_ms_ = 0;
+
+    bool active_ = false;
+    bool has_run_ = false;
+    uint32_t routine_start_ms_ = 0;
+    uint32_t shown_step_ = 0;
+    // Numerals of each tube by ascending wear, taken when a routine starts
+    std::array<std::array<uint8_t, 10>, kNixieTubeCount> order_{};
+};
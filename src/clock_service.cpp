@@ -0,0 +1,215 @@
+#include "clock_service.h"
+#include <algorithm>
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <chrono>
+#endif
+
+namespace
+{
+constexpr int64_t kUsPerSecond = 1000000;
+constexpr int64_t kPpbScale = 1000000000;
+constexpr int64_t kSecondsPerDay = 86400;
+
+// esp_timer on the target; steady_clock lets the host tests run the same code
+int64_t local_now_us()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+// Days from 1970-01-01 of a proleptic Gregorian date (month 1-12)
+int64_t days_from_civil(int64_t year, int64_t month, int64_t day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t year_of_era = year - era * 400;
+    const int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+void civil_from_days(int64_t days, struct tm &timeinfo)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t day_of_era = days - era * 146097;
+    const int64_t year_of_era =
+        (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const int64_t mp = (5 * day_of_year + 2) / 153;
+    const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    timeinfo.tm_year = static_cast<int>(year_of_era + era * 400 + (month <= 2) - 1900);
+    timeinfo.tm_mon = static_cast<int>(month - 1);
+    timeinfo.tm_mday = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+}
+
+int64_t floor_div(int64_t value, int64_t divisor)
+{
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
+} // namespace
+
+ClockService::ClockService()
+{
+    publish();
+}
+
+int64_t ClockService::extrapolate(const Anchor &anchor, int64_t local_us)
+{
+    const int64_t elapsed_us = local_us - anchor.local_us;
+    const int64_t slewed_us = std::clamp<int64_t>(elapsed_us, 0, anchor.slew_us);
+    return anchor.wall_us + elapsed_us + elapsed_us * anchor.rate_ppb / kPpbScale +
+           slewed_us * anchor.slew_ppb / kPpbScale;
+}
+
+void ClockService::step(int64_t wall_us, int64_t local_us)
+{
+    anchor_ = {wall_us, local_us, rate_ppb_, 0, 0, true};
+    base_wall_us_ = wall_us;
+    base_local_us_ = local_us;
+    stats_.steps++;
+}
+
+bool ClockService::sync_edge(int64_t wall_s, int64_t edge_us, bool counted)
+{
+    const int64_t wall_us = wall_s * kUsPerSecond;
+    stats_.syncs++;
+    if (!anchor_.valid) {
+        stats_.last_offset_us = 0;
+        step(wall_us, edge_us);
+        publish();
+        return true;
+    }
+
+    const int64_t predicted_us = extrapolate(anchor_, edge_us);
+    const int64_t offset_us = wall_us - predicted_us;
+    stats_.last_offset_us = static_cast<int32_t>(std::clamp<int64_t>(offset_us, INT32_MIN, INT32_MAX));
+    if (offset_us > kStepThresholdUs || offset_us < -kStepThresholdUs) {
+        if (counted) {
+            stats_.refused++;
+            publish();
+            return false;
+        }
+        step(wall_us, edge_us);
+        publish();
+        return true;
+    }
+
+    // Frequency from the RTC's seconds against esp_timer over the window,
+    // smoothed so one late edge moves it little
+    const int64_t local_span_us = edge_us - base_local_us_;
+    if (local_span_us >= kRateWindowUs) {
+        const int64_t wall_span_us = wall_us - base_wall_us_;
+        const int64_t measured_ppb = (wall_span_us - local_span_us) * kPpbScale / local_span_us;
+        rate_ppb_ = rate_known_ ? rate_ppb_ + (measured_ppb - rate_ppb_) / 4 : measured_ppb;
+        rate_ppb_ = std::clamp(rate_ppb_, -kMaxRatePpb, kMaxRatePpb);
+        rate_known_ = true;
+        base_wall_us_ = wall_us;
+        base_local_us_ = edge_us;
+    }
+
+    // Continue from the prediction so the time has no jump, and run fast or
+    // slow just long enough to work the offset off
+    const int64_t slew_us = (offset_us < 0 ? -offset_us : offset_us) * (kPpbScale / kSlewPpb);
+    anchor_ = {predicted_us, edge_us, rate_ppb_, offset_us < 0 ? -kSlewPpb : kSlewPpb, slew_us, true};
+    publish();
+    return true;
+}
+
+void ClockService::sync_coarse(int64_t wall_s, int64_t read_us)
+{
+    const int64_t wall_us = wall_s * kUsPerSecond;
+    stats_.syncs++;
+    if (!anchor_.valid) {
+        // Middle of the second: at most half a second either way
+        stats_.last_offset_us = 0;
+        step(wall_us + kUsPerSecond / 2, read_us);
+        publish();
+        return;
+    }
+
+    const int64_t predicted_us = extrapolate(anchor_, read_us);
+    if (predicted_us < wall_us) {
+        stats_.last_offset_us = static_cast<int32_t>(std::min<int64_t>(wall_us - predicted_us, INT32_MAX));
+        step(wall_us, read_us);
+    } else if (predicted_us >= wall_us + kUsPerSecond) {
+        stats_.last_offset_us =
+            static_cast<int32_t>(std::max<int64_t>(wall_us + kUsPerSecond - 1 - predicted_us, INT32_MIN));
+        step(wall_us + kUsPerSecond - 1, read_us);
+    } else {
+        // Consistent with the RTC; keep free-running at the estimated rate
+        stats_.last_offset_us = 0;
+        return;
+    }
+    publish();
+}
+
+void ClockService::publish()
+{
+    stats_.valid = anchor_.valid;
+    stats_.rate_ppb = static_cast<int32_t>(rate_ppb_);
+    published_.publish({anchor_, stats_});
+}
+
+bool ClockService::valid() const
+{
+    Snapshot snapshot;
+    published_.read(snapshot);
+    return snapshot.anchor.valid;
+}
+
+int64_t ClockService::wall_us(int64_t local_us) const
+{
+    Snapshot snapshot;
+    published_.read(snapshot);
+    return extrapolate(snapshot.anchor, local_us);
+}
+
+int64_t ClockService::now_ms() const
+{
+    return floor_div(wall_us(local_now_us()), 1000);
+}
+
+bool ClockService::now(struct tm *timeinfo, uint16_t *ms) const
+{
+    Snapshot snapshot;
+    published_.read(snapshot);
+    if (!snapshot.anchor.valid) {
+        return false;
+    }
+    const int64_t wall_ms = floor_div(extrapolate(snapshot.anchor, local_now_us()), 1000);
+    const int64_t seconds = floor_div(wall_ms, 1000);
+    const int64_t days = floor_div(seconds, kSecondsPerDay);
+    const int64_t second_of_day = seconds - days * kSecondsPerDay;
+
+    *timeinfo = {};
+    civil_from_days(days, *timeinfo);
+    timeinfo->tm_hour = static_cast<int>(second_of_day / 3600);
+    timeinfo->tm_min = static_cast<int>(second_of_day / 60 % 60);
+    timeinfo->tm_sec = static_cast<int>(second_of_day % 60);
+    timeinfo->tm_wday = static_cast<int>((days % 7 + 11) % 7); // 1970-01-01 was a Thursday
+    if (ms) {
+        *ms = static_cast<uint16_t>(wall_ms - seconds * 1000);
+    }
+    return true;
+}
+
+ClockServiceStats ClockService::stats() const
+{
+    Snapshot snapshot;
+    published_.read(snapshot);
+    return snapshot.stats;
+}
+
+int64_t ClockService::wall_seconds(const struct tm &timeinfo)
+{
+    const int64_t days = days_from_civil(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday);
+    return days * kSecondsPerDay + timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec;
+}
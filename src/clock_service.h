@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include "frame_buffer.h"
+
+struct ClockServiceStats
+{
+    bool valid;
+    int32_t rate_ppb;       // estimated esp_timer error against the RTC; + means it runs slow
+    int32_t last_offset_us; // RTC minus the clock at the last sync
+    uint32_t syncs;
+    uint32_t steps;         // jumps instead of slews: first sync, time set, lost sync
+    uint32_t refused;       // counted seconds a step away from the clock, left for a read
+};
+
+// Wall time at millisecond resolution without the I2C bus. The RTC is the
+// reference; between syncs the time is extrapolated from esp_timer at the
+// estimated rate. Small offsets are slewed out by running up to 1% fast or
+// slow, 50 ms in 5 s, so the time never goes backwards except at a counted
+// step.
+//
+// One task (the SystemController) feeds it; any task may read it, lock-free.
+// Wall time is the RTC's local time counted in seconds from 1970-01-01, not
+// UTC.
+class ClockService
+{
+public:
+    // Offsets beyond this are stepped rather than slewed
+    static constexpr int64_t kStepThresholdUs = 50000;
+    // The span a rate estimate is measured over
+    static constexpr int64_t kRateWindowUs = 64 * 1000000LL;
+    // Bound on the estimated oscillator error, 500 ppm
+    static constexpr int64_t kMaxRatePpb = 500000;
+    // How much faster or slower than that rate an offset is worked off, 1%
+    static constexpr int64_t kSlewPpb = 10000000;
+
+    ClockService();
+
+    // Writer side. wall_s began at edge_us, e.g. a DS3231 SQW falling edge.
+    // A counted wall_s was stepped on from an earlier read rather than read
+    // at this edge; if it is a step away from the clock, an edge was lost or
+    // doubled and the clock is left alone. Returns false then, so the caller
+    // can read the RTC and sync again.
+    bool sync_edge(int64_t wall_s, int64_t edge_us, bool counted = false);
+    // Writer side. The RTC read wall_s at read_us, so the true time lies
+    // somewhere in that second; only a clock outside it is stepped.
+    void sync_coarse(int64_t wall_s, int64_t read_us);
+
+    // Reader side, any task
+    bool valid() const;
+    int64_t now_ms() const;
+    int64_t wall_us(int64_t local_us) const;
+    // Broken-down wall time and the millisecond within the second; false
+    // until the first sync
+    bool now(struct tm *timeinfo, uint16_t *ms) const;
+    ClockServiceStats stats() const;
+
+    // Seconds from 1970-01-01 of a broken-down time, without a time zone
+    static int64_t wall_seconds(const struct tm &timeinfo);
+
+private:
+    struct Anchor
+    {
+        int64_t wall_us;  // wall time at local_us
+        int64_t local_us; // esp_timer
+        int64_t rate_ppb; // wall runs this much faster than esp_timer
+        int64_t slew_ppb; // and on top of that, for the first slew_us
+        int64_t slew_us;
+        bool valid;
+    };
+
+    struct Snapshot
+    {
+        Anchor anchor;
+        ClockServiceStats stats;
+    };
+
+    static int64_t extrapolate(const Anchor &anchor, int64_t local_us);
+    void step(int64_t wall_us, int64_t local_us);
+    void publish();
+
+    // Writer state
+    Anchor anchor_{};
+    int64_t rate_ppb_ = 0;
+    bool rate_known_ = false;
+    int64_t base_wall_us_ = 0; // start of the current rate window
+    int64_t base_local_us_ = 0;
+    ClockServiceStats stats_{};
+
+    FrameBuffer<Snapshot> published_;
+};
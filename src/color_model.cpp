@@ -23,6 +23,98 @@ const uint8_t kGammaTable[256] = {
    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
 };
+
+// The same 2.2 curve in 8.8 fixed point, for the dithered path; rounding
+// an entry to 8 bits gives kGammaTable
+const uint16_t kGammaTable16[256] = {
+        0,     0,     2,     4,     7,    11,    17,    24,    32,    42,    53,    65,
+       78,    94,   110,   128,   148,   169,   191,   216,   241,   269,   298,   328,
+      360,   394,   430,   467,   506,   547,   589,   633,   679,   726,   776,   827,
+      880,   934,   991,  1049,  1109,  1171,  1235,  1300,  1368,  1437,  1508,  1581,
+     1656,  1733,  1812,  1893,  1975,  2060,  2146,  2235,  2325,  2417,  2512,  2608,
+     2706,  2806,  2908,  3013,  3119,  3227,  3337,  3450,  3564,  3680,  3798,  3919,
+     4041,  4166,  4292,  4421,  4552,  4685,  4819,  4956,  5096,  5237,  5380,  5525,
+     5673,  5823,  5974,  6128,  6284,  6442,  6603,  6765,  6930,  7097,  7266,  7437,
+     7610,  7786,  7963,  8143,  8325,  8509,  8696,  8885,  9075,  9268,  9464,  9661,
+     9861, 10063, 10267, 10474, 10682, 10893, 11107, 11322, 11540, 11760, 11982, 12207,
+    12433, 12663, 12894, 13128, 13363, 13602, 13842, 14085, 14330, 14578, 14827, 15080,
+    15334, 15591, 15850, 16111, 16375, 16641, 16909, 17180, 17453, 17729, 18006, 18287,
+    18569, 18854, 19141, 19431, 19723, 20017, 20314, 20613, 20915, 21218, 21525, 21833,
+    22144, 22458, 22774, 23092, 23413, 23736, 24062, 24390, 24720, 25053, 25388, 25726,
+    26066, 26408, 26753, 27101, 27451, 27803, 28158, 28515, 28875, 29237, 29602, 29969,
+    30338, 30710, 31085, 31462, 31841, 32223, 32608, 32995, 33384, 33776, 34170, 34567,
+    34967, 35369, 35773, 36180, 36589, 37001, 37416, 37833, 38252, 38674, 39099, 39526,
+    39956, 40388, 40823, 41260, 41700, 42142, 42587, 43034, 43484, 43937, 44392, 44849,
+    45310, 45772, 46238, 46706, 47176, 47649, 48125, 48603, 49084, 49567, 50053, 50542,
+    51033, 51526, 52023, 52522, 53023, 53527, 54034, 54543, 55055, 55570, 56087, 56607,
+    57129, 57654, 58182, 58712, 59245, 59780, 60318, 60859, 61402, 61948, 62497, 63048,
+    63602, 64159, 64718, 65280,
+};
+
+// Per hue: sector (0-5) in the high byte, position inside the 60 degree
+// sector scaled to 0-255 in the low byte
+constexpr std::array<uint16_t, 360> make_hue_sector_table()
+{
+    std::array<uint16_t, 360> table{};
+    for (uint16_t hue = 0; hue < 360; ++hue)
+    {
+        const uint16_t position = static_cast<uint16_t>(((hue % 60) * 256 + 30) / 60);
+        table[hue] = static_cast<uint16_t>(((hue / 60) << 8) | std::min<uint16_t>(position, 255));
+    }
+    return table;
+}
+
+constexpr std::array<uint16_t, 360> kHueSectorTable = make_hue_sector_table();
+
+// Channel values in 8.8 fixed point; the ramp rises on even sectors and
+// falls on odd ones, as in the float version's 1 - |h mod 2 - 1|
+inline void hsv_to_rgb_8_8(uint16_t hue, uint8_t saturation, uint8_t value,
+                           uint8_t &red, uint8_t &green, uint8_t &blue)
+{
+    const uint16_t entry = kHueSectorTable[hue % 360];
+    const uint32_t sector = entry >> 8;
+    const uint32_t position = entry & 0xFF;
+
+    // v * s / 255 in 8.8, using 257 / 65536 for 1 / 255
+    const uint32_t chroma = (static_cast<uint32_t>(value) * saturation * 257) >> 8;
+    const uint32_t ramp = (sector & 1) ? 256 - position : position;
+    const uint32_t x = (chroma * ramp) >> 8;
+    const uint32_t match = (static_cast<uint32_t>(value) << 8) - chroma;
+
+    uint32_t r = 0;
+    uint32_t g = 0;
+    uint32_t b = 0;
+    switch (sector)
+    {
+    case 0:
+        r = chroma;
+        g = x;
+        break;
+    case 1:
+        r = x;
+        g = chroma;
+        break;
+    case 2:
+        g = chroma;
+        b = x;
+        break;
+    case 3:
+        g = x;
+        b = chroma;
+        break;
+    case 4:
+        r = x;
+        b = chroma;
+        break;
+    default:
+        r = chroma;
+        b = x;
+        break;
+    }
+    red = static_cast<uint8_t>((r + match + 128) >> 8);
+    green = static_cast<uint8_t>((g + match + 128) >> 8);
+    blue = static_cast<uint8_t>((b + match + 128) >> 8);
+}
 } // namespace
 
 RgbColor hsv_to_rgb(const HsvColor &hsv)
@@ -78,6 +170,13 @@ RgbColor hsv_to_rgb(const HsvColor &hsv)
     return RgbColor{red, green, blue};
 }
 
+RgbColor hsv_to_rgb_fixed(const HsvColor &hsv)
+{
+    RgbColor rgb{};
+    hsv_to_rgb_8_8(hsv.hue, hsv.saturation, hsv.value, rgb.red, rgb.green, rgb.blue);
+    return rgb;
+}
+
 HsvColor rgb_to_hsv(const RgbColor &rgb)
 {
     float r = static_cast<float>(rgb.red) / 255.0f;
@@ -130,3 +229,40 @@ RgbColor apply_gamma(const RgbColor &linear_color)
     corrected.blue = kGammaTable[linear_color.blue];
     return corrected;
 }
+
+void hsv_to_rgb_gamma(const HsvPlanes &in, const RgbPlanes &out)
+{
+    const std::size_t count = std::min({in.hue.size(), in.saturation.size(), in.value.size(),
+                                        out.red.size(), out.green.size(), out.blue.size()});
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+        hsv_to_rgb_8_8(in.hue[i], in.saturation[i], in.value[i], red, green, blue);
+        out.red[i] = kGammaTable[red];
+        out.green[i] = kGammaTable[green];
+        out.blue[i] = kGammaTable[blue];
+    }
+}
+
+uint16_t gamma16(uint8_t level)
+{
+    return kGammaTable16[level];
+}
+
+void hsv_to_rgb_gamma16(const HsvPlanes &in, const RgbPlanes16 &out)
+{
+    const std::size_t count = std::min({in.hue.size(), in.saturation.size(), in.value.size(),
+                                        out.red.size(), out.green.size(), out.blue.size()});
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+        hsv_to_rgb_8_8(in.hue[i], in.saturation[i], in.value[i], red, green, blue);
+        out.red[i] = kGammaTable16[red];
+        out.green[i] = kGammaTable16[green];
+        out.blue[i] = kGammaTable16[blue];
+    }
+}
@@ -7,11 +7,17 @@
 #include "esp_vfs_dev.h"
 #include "linenoise/linenoise.h"
 #include "esp_mac.h"
+#include "i2c_bus/i2c_bus.h"
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 
 static const char *TAG = "CliDaemon";
 static SystemController *g_system_controller = nullptr;
+static INixieDriver *g_nixie_driver = nullptr;
+static SettingsStore *g_settings_store = nullptr;
+static DisplayDaemon *g_display_daemon = nullptr;
+static ILedDriver *g_led_driver = nullptr;
 
 #ifndef GIT_COMMIT_HASH
 #define GIT_COMMIT_HASH "unknown"
@@ -45,7 +51,7 @@ static int set_nixie_func(int argc, char **argv)
         msg.data.cli.value = number;
         
         if (g_system_controller) {
-            xQueueSend(g_system_controller->get_queue(), &msg, 0);
+            post_system_message(g_system_controller->get_queue(), msg);
         }
     }
     return 0;
@@ -55,6 +61,7 @@ static int set_nixie_func(int argc, char **argv)
 struct set_backlight_args {
     struct arg_str *rgb;
     struct arg_int *brightness;
+    struct arg_int *tube;
     struct arg_end *end;
 };
 
@@ -73,6 +80,16 @@ static int set_backlight_func(int argc, char **argv)
     msg.data.cli.type = CliCommandType::SET_BACKLIGHT;
     msg.data.cli.backlight.has_color = false;
     msg.data.cli.backlight.has_brightness = false;
+    msg.data.cli.backlight.tube = 0;
+
+    if (backlight_args.tube->count > 0) {
+        const int tube = backlight_args.tube->ival[0];
+        if (tube < 1 || tube > static_cast<int>(kNixieTubeCount)) {
+            printf("Tube must be 1-%u\n", static_cast<unsigned>(kNixieTubeCount));
+            return 1;
+        }
+        msg.data.cli.backlight.tube = static_cast<uint8_t>(tube);
+    }
 
     if (backlight_args.rgb->count > 0) {
         int r, g, b;
@@ -98,7 +115,111 @@ static int set_backlight_func(int argc, char **argv)
     }
 
     if (g_system_controller) {
-        xQueueSend(g_system_controller->get_queue(), &msg, 0);
+        post_system_message(g_system_controller->get_queue(), msg);
+    }
+    return 0;
+}
+
+// --- Command: set_transition ---
+struct set_transition_args {
+    struct arg_str *type;
+    struct arg_int *ms;
+    struct arg_end *end;
+};
+
+static struct set_transition_args transition_args;
+
+static int set_transition_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&transition_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, transition_args.end, "set_transition");
+        return 1;
+    }
+
+    static const struct {
+        const char *name;
+        NixieTransition type;
+    } kTransitions[] = {
+        {"none", NixieTransition::NONE},
+        {"fade", NixieTransition::CROSSFADE},
+        {"roll", NixieTransition::SLOT_ROLL},
+        {"scroll", NixieTransition::SCROLL},
+    };
+
+    const char *name = transition_args.type->sval[0];
+    int type = -1;
+    for (const auto &entry : kTransitions) {
+        if (strcmp(name, entry.name) == 0) {
+            type = static_cast<int>(entry.type);
+        }
+    }
+    if (type < 0) {
+        printf("Unknown transition '%s'. Use none, fade, roll or scroll\n", name);
+        return 1;
+    }
+
+    int duration_ms = 150;
+    if (transition_args.ms->count > 0) {
+        duration_ms = transition_args.ms->ival[0];
+        if (duration_ms < 0 || duration_ms > 1000) {
+            printf("Duration must be 0-1000 ms\n");
+            return 1;
+        }
+    }
+
+    SystemMessage msg;
+    msg.event = SystemEvent::CLI_COMMAND;
+    msg.data.cli.type = CliCommandType::SET_TRANSITION;
+    msg.data.cli.transition.type = static_cast<uint8_t>(type);
+    msg.data.cli.transition.duration_ms = static_cast<uint16_t>(duration_ms);
+    printf("set nixie transition %s, %d ms\n", name, duration_ms);
+
+    if (g_system_controller) {
+        post_system_message(g_system_controller->get_queue(), msg);
+    }
+    return 0;
+}
+
+// --- Command: set_effect ---
+struct set_effect_args {
+    struct arg_str *type;
+    struct arg_end *end;
+};
+
+static struct set_effect_args effect_args;
+
+static int set_effect_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&effect_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, effect_args.end, "set_effect");
+        return 1;
+    }
+
+    // Indexed by DisplayStateData::effect_id
+    static const char *const kEffects[] = {"none", "breath", "rainbow", "chase", "wave"};
+
+    const char *name = effect_args.type->sval[0];
+    int effect_id = -1;
+    for (size_t i = 0; i < sizeof(kEffects) / sizeof(kEffects[0]); ++i) {
+        if (strcmp(name, kEffects[i]) == 0) {
+            effect_id = static_cast<int>(i);
+        }
+    }
+    if (effect_id < 0) {
+        printf("Unknown effect '%s'. Use none, breath, rainbow, chase or wave\n", name);
+        return 1;
+    }
+
+    SystemMessage msg;
+    msg.event = SystemEvent::CLI_COMMAND;
+    msg.data.cli.type = CliCommandType::SET_EFFECT;
+    msg.data.cli.effect_id = static_cast<uint8_t>(effect_id);
+    printf("set backlight effect %s\n", name);
+
+    if (g_system_controller) {
+        post_system_message(g_system_controller->get_queue(), msg);
     }
     return 0;
 }
@@ -119,6 +240,391 @@ static int ggtool_func(int argc, char **argv)
     return 0;
 }
 
+// --- Command: i2c_stats ---
+struct i2c_stats_args {
+    struct arg_lit *reset;
+    struct arg_end *end;
+};
+
+static struct i2c_stats_args i2c_args;
+
+static const char *i2c_priority_name(I2cPriority priority)
+{
+    switch (priority) {
+        case I2cPriority::REALTIME: return "rt";
+        case I2cPriority::NORMAL: return "norm";
+        case I2cPriority::BACKGROUND: return "bg";
+        default: return "?";
+    }
+}
+
+static int i2c_stats_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&i2c_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, i2c_args.end, "i2c_stats");
+        return 1;
+    }
+
+    for (int port = 0; port < I2C_NUM_MAX; ++port) {
+        I2cBus *bus = I2cBus::find(static_cast<i2c_port_t>(port));
+        if (!bus) {
+            continue;
+        }
+        if (i2c_args.reset->count > 0) {
+            bus->reset_stats();
+            printf("I2C%d statistics cleared\n", port);
+            continue;
+        }
+
+        I2cDeviceStats stats[I2cBus::kMaxDevices];
+        const size_t count = bus->get_stats(stats, I2cBus::kMaxDevices);
+        const int64_t window_us = bus->stats_window_us();
+        printf("I2C%d over %lld ms\n", port, window_us / 1000);
+        printf("device    addr prio  txns      err   miss  bytes      util%%  avg_wait  max_wait\n");
+        for (size_t i = 0; i < count; ++i) {
+            const I2cDeviceStats &dev = stats[i];
+            const float util = window_us > 0 ? 100.0f * dev.busy_us / window_us : 0.0f;
+            const uint32_t avg_wait = dev.transactions > 0
+                                          ? static_cast<uint32_t>(dev.wait_us / dev.transactions)
+                                          : 0;
+            printf("%-9s 0x%02x %-5s %-9lu %-5lu %-5lu %-10lu %5.1f  %6luus  %6luus\n",
+                   dev.name, dev.address, i2c_priority_name(dev.priority),
+                   static_cast<unsigned long>(dev.transactions),
+                   static_cast<unsigned long>(dev.errors),
+                   static_cast<unsigned long>(dev.deadline_misses),
+                   static_cast<unsigned long>(dev.bytes),
+                   util,
+                   static_cast<unsigned long>(avg_wait),
+                   static_cast<unsigned long>(dev.max_wait_us));
+        }
+    }
+    return 0;
+}
+
+// --- Command: nixie_stats ---
+struct nixie_stats_args {
+    struct arg_lit *reset;
+    struct arg_end *end;
+};
+
+static struct nixie_stats_args scan_args;
+
+static int nixie_stats_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&scan_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, scan_args.end, "nixie_stats");
+        return 1;
+    }
+    if (!g_nixie_driver) {
+        return 1;
+    }
+    if (scan_args.reset->count > 0) {
+        g_nixie_driver->reset_scan_stats();
+        printf("Nixie scan statistics cleared\n");
+        return 0;
+    }
+
+    const NixieScanStats stats = g_nixie_driver->get_scan_stats();
+    printf("frames: %lu, I2C bytes/frame: %lu (max %lu), heap allocs/frame: %lu\n",
+           static_cast<unsigned long>(stats.frames),
+           static_cast<unsigned long>(stats.last_frame_bytes),
+           static_cast<unsigned long>(stats.max_frame_bytes),
+           static_cast<unsigned long>(stats.last_frame_allocations));
+    printf("slots: %lu, missed: %lu, max start error: %luus\n",
+           static_cast<unsigned long>(stats.slots),
+           static_cast<unsigned long>(stats.missed_slots),
+           static_cast<unsigned long>(stats.max_slot_error_us));
+    printf("start error     slots\n");
+    uint32_t lower = 0;
+    for (size_t i = 0; i < kNixieSlotErrorBinsUs.size(); ++i) {
+        printf("%4lu-%4luus     %lu\n",
+               static_cast<unsigned long>(lower),
+               static_cast<unsigned long>(kNixieSlotErrorBinsUs[i]),
+               static_cast<unsigned long>(stats.slot_error_histogram[i]));
+        lower = kNixieSlotErrorBinsUs[i];
+    }
+    printf("    >%4luus     %lu\n",
+           static_cast<unsigned long>(lower),
+           static_cast<unsigned long>(stats.slot_error_histogram.back()));
+    return 0;
+}
+
+// --- Command: nixie_cal ---
+struct nixie_cal_args {
+    struct arg_int *tube;
+    struct arg_int *digit;
+    struct arg_int *level;
+    struct arg_lit *save;
+    struct arg_end *end;
+};
+
+static struct nixie_cal_args cal_args;
+
+static int nixie_cal_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&cal_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, cal_args.end, "nixie_cal");
+        return 1;
+    }
+    if (!g_nixie_driver) {
+        return 1;
+    }
+
+    NixieCalibration calibration = g_nixie_driver->get_calibration();
+    if (cal_args.level->count > 0) {
+        const int level = cal_args.level->ival[0];
+        if (level < 0 || level > 255) {
+            printf("Level must be 0-255\n");
+            return 1;
+        }
+        // No --tube / --digit means every tube / every numeral
+        size_t first_tube = 0, last_tube = calibration.size() - 1;
+        if (cal_args.tube->count > 0) {
+            const int tube = cal_args.tube->ival[0];
+            if (tube < 1 || tube > static_cast<int>(calibration.size())) {
+                printf("Tube must be 1-%u\n", static_cast<unsigned>(calibration.size()));
+                return 1;
+            }
+            first_tube = last_tube = static_cast<size_t>(tube - 1);
+        }
+        size_t first_digit = 0, last_digit = 9;
+        if (cal_args.digit->count > 0) {
+            const int digit = cal_args.digit->ival[0];
+            if (digit < 0 || digit > 9) {
+                printf("Digit must be 0-9\n");
+                return 1;
+            }
+            first_digit = last_digit = static_cast<size_t>(digit);
+        }
+        for (size_t t = first_tube; t <= last_tube; ++t) {
+            for (size_t d = first_digit; d <= last_digit; ++d) {
+                calibration[t][d] = static_cast<uint8_t>(level);
+            }
+        }
+        g_nixie_driver->set_calibration(calibration);
+    }
+    if (cal_args.save->count > 0) {
+        if (!g_settings_store || !g_settings_store->save_calibration(calibration)) {
+            printf("Failed to save calibration\n");
+            return 1;
+        }
+        printf("Calibration saved\n");
+    }
+
+    printf("tube    0   1   2   3   4   5   6   7   8   9\n");
+    for (size_t t = 0; t < calibration.size(); ++t) {
+        printf("%-4u", static_cast<unsigned>(t + 1));
+        for (uint8_t level : calibration[t]) {
+            printf("%4u", level);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+// --- Command: nixie_wear ---
+static int nixie_wear_func(int argc, char **argv)
+{
+    if (!g_nixie_driver) {
+        return 1;
+    }
+
+    // Hours each cathode was selected, then each as a share of that tube's
+    // busiest cathode: low shares are the ones at risk of poisoning
+    const NixieWear wear = g_nixie_driver->get_wear();
+    printf("on-time (h)\n");
+    printf("tube       0      1      2      3      4      5      6      7      8      9\n");
+    for (size_t t = 0; t < wear.size(); ++t) {
+        printf("%-4u", static_cast<unsigned>(t + 1));
+        for (uint32_t seconds : wear[t]) {
+            printf("%7.1f", seconds / 3600.0f);
+        }
+        printf("\n");
+    }
+
+    printf("share of busiest (%%)\n");
+    printf("tube    0   1   2   3   4   5   6   7   8   9  least\n");
+    for (size_t t = 0; t < wear.size(); ++t) {
+        const uint32_t busiest = *std::max_element(wear[t].begin(), wear[t].end());
+        const size_t least = std::min_element(wear[t].begin(), wear[t].end()) - wear[t].begin();
+        printf("%-4u", static_cast<unsigned>(t + 1));
+        for (uint32_t seconds : wear[t]) {
+            printf("%4u", busiest ? static_cast<unsigned>((uint64_t(seconds) * 100) / busiest) : 0u);
+        }
+        printf("%7u\n", static_cast<unsigned>(least));
+    }
+    return 0;
+}
+
+// --- Command: led_stats ---
+struct led_stats_args {
+    struct arg_lit *reset;
+    struct arg_end *end;
+};
+
+static struct led_stats_args led_args;
+
+static const char *led_blend_name(LedBlend blend)
+{
+    switch (blend) {
+        case LedBlend::NORMAL: return "normal";
+        case LedBlend::MULTIPLY: return "mul";
+        case LedBlend::ADD: return "add";
+        default: return "?";
+    }
+}
+
+static void print_frame_phase(const char *name, const DisplayPhaseTiming &timing, uint32_t frames)
+{
+    const uint32_t avg_us = frames > 0 ? static_cast<uint32_t>(timing.total_us / frames) : 0;
+    printf("%-10s %-8lu %-8lu %lu\n", name,
+           static_cast<unsigned long>(timing.last_us),
+           static_cast<unsigned long>(avg_us),
+           static_cast<unsigned long>(timing.max_us));
+}
+
+static int led_stats_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&led_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, led_args.end, "led_stats");
+        return 1;
+    }
+    if (!g_display_daemon || !g_led_driver) {
+        return 1;
+    }
+    if (led_args.reset->count > 0) {
+        g_display_daemon->reset_render_stats();
+        g_led_driver->reset_show_stats();
+        printf("LED render statistics cleared\n");
+        return 0;
+    }
+
+    const LedRenderStats stats = g_display_daemon->get_render_stats();
+    const uint32_t avg_us = stats.composed > 0 ? static_cast<uint32_t>(stats.total_us / stats.composed) : 0;
+    printf("frames: %lu, composed: %lu, skipped unchanged: %lu\n",
+           static_cast<unsigned long>(stats.frames),
+           static_cast<unsigned long>(stats.composed),
+           static_cast<unsigned long>(stats.frames - stats.composed));
+    printf("render per composed frame: last %luus, avg %luus, max %luus\n",
+           static_cast<unsigned long>(stats.last_us),
+           static_cast<unsigned long>(avg_us),
+           static_cast<unsigned long>(stats.max_us));
+    const DisplayFrameStats frame = g_display_daemon->get_frame_stats();
+    printf("frame rate: %lu Hz, budget %luus, last dt %luus, late frames: %lu, dropped: %lu\n",
+           static_cast<unsigned long>(frame.rate_hz),
+           static_cast<unsigned long>(frame.period_us),
+           static_cast<unsigned long>(frame.last_dt_us),
+           static_cast<unsigned long>(frame.late),
+           static_cast<unsigned long>(frame.dropped));
+    printf("per frame  last_us  avg_us   max_us\n");
+    print_frame_phase("lag", frame.lag, frame.frames);
+    print_frame_phase("process", frame.process, frame.frames);
+    print_frame_phase("render", frame.render, frame.frames);
+    print_frame_phase("show", frame.show, frame.frames);
+    const LedShowStats shows = g_led_driver->get_show_stats();
+    printf("strip frames sent: %lu (keep-alive %lu), skipped unchanged: %lu\n",
+           static_cast<unsigned long>(shows.transmitted),
+           static_cast<unsigned long>(shows.keepalive),
+           static_cast<unsigned long>(shows.skipped));
+    printf("layer     blend   on  draws     last_us  max_us\n");
+    for (size_t i = 0; i < stats.layer_count; ++i) {
+        const LedLayerStats &layer = stats.layers[i];
+        printf("%-9s %-7s %-3s %-9lu %-8lu %lu\n",
+               layer.name, led_blend_name(layer.blend), layer.enabled ? "yes" : "no",
+               static_cast<unsigned long>(layer.draws),
+               static_cast<unsigned long>(layer.last_us),
+               static_cast<unsigned long>(layer.max_us));
+    }
+    const DisplayStateStats state = g_display_daemon->state().stats();
+    printf("state writes since boot: %lu, coalesced: %lu, applied in %lu updates\n",
+           static_cast<unsigned long>(state.writes),
+           static_cast<unsigned long>(state.coalesced),
+           static_cast<unsigned long>(state.takes));
+    return 0;
+}
+
+// --- Command: sys_stats ---
+struct sys_stats_args {
+    struct arg_lit *reset;
+    struct arg_end *end;
+};
+
+static struct sys_stats_args sys_args;
+
+static const char *system_event_name(size_t event)
+{
+    switch (static_cast<SystemEvent>(event)) {
+        case SystemEvent::BUTTON_PRESSED: return "button";
+        case SystemEvent::ALARM_TRIGGERED: return "alarm";
+        case SystemEvent::WIFI_CONNECTED: return "wifi_up";
+        case SystemEvent::WIFI_DISCONNECTED: return "wifi_down";
+        case SystemEvent::RTC_UPDATE: return "rtc";
+        case SystemEvent::CLI_COMMAND: return "cli";
+        case SystemEvent::BATTERY_UPDATE: return "battery";
+        case SystemEvent::POWER_UPDATE: return "power";
+        default: return "?";
+    }
+}
+
+static void print_system_latency(const char *name, const SystemLatency &latency)
+{
+    const uint32_t avg_us = latency.handled > 0 ? static_cast<uint32_t>(latency.total_us / latency.handled) : 0;
+    printf("%-10s %-9lu %-9lu %lu\n", name,
+           static_cast<unsigned long>(latency.handled),
+           static_cast<unsigned long>(avg_us),
+           static_cast<unsigned long>(latency.max_us));
+}
+
+static int sys_stats_func(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&sys_args);
+    if (nerrors > 0) {
+        arg_print_errors(stdout, sys_args.end, "sys_stats");
+        return 1;
+    }
+    if (!g_system_controller) {
+        return 1;
+    }
+    if (sys_args.reset->count > 0) {
+        g_system_controller->reset_stats();
+        printf("System controller statistics cleared\n");
+        return 0;
+    }
+
+    const SystemControllerStats stats = g_system_controller->get_stats();
+    printf("max queue depth: %lu\n", static_cast<unsigned long>(stats.max_queue_depth));
+    printf("rtc edges: %lu, fallback ticks: %lu, rtc reads: %lu\n",
+           static_cast<unsigned long>(stats.rtc_edges),
+           static_cast<unsigned long>(stats.fallback_ticks),
+           static_cast<unsigned long>(stats.rtc_reads));
+    printf("event      handled   avg_us    max_us\n");
+    for (size_t event = 0; event < stats.events.size(); ++event) {
+        if (stats.events[event].handled > 0) {
+            print_system_latency(system_event_name(event), stats.events[event]);
+        }
+    }
+    print_system_latency("tick", stats.tick);
+
+    const ClockServiceStats clock = g_system_controller->clock().stats();
+    struct tm now = {};
+    uint16_t ms = 0;
+    if (clock.valid && g_system_controller->clock().now(&now, &ms)) {
+        printf("clock: %04d-%02d-%02d %02d:%02d:%02d.%03u\n", now.tm_year + 1900, now.tm_mon + 1, now.tm_mday,
+               now.tm_hour, now.tm_min, now.tm_sec, ms);
+    } else {
+        printf("clock: not synced\n");
+    }
+    printf("clock rate: %ld ppb, last offset: %ld us, syncs: %lu, steps: %lu, refused: %lu\n",
+           static_cast<long>(clock.rate_ppb), static_cast<long>(clock.last_offset_us),
+           static_cast<unsigned long>(clock.syncs), static_cast<unsigned long>(clock.steps),
+           static_cast<unsigned long>(clock.refused));
+    return 0;
+}
+
 // --- Command: get_hw_version ---
 static int get_hw_version_func(int argc, char **argv)
 {
@@ -150,8 +656,20 @@ static int help_func(int argc, char **argv)
     // TODO: complete the help dialog
     printf("============= NIXIE TUBE CLOCK CLI V0.9.0 ============================\n");
     printf("help                                            Show this help message\n");
-    printf("set_backlight --rgb <r,g,b> --brightness <int>  Set LED backlight color and brightness\n");
+    printf("set_backlight --rgb <r,g,b> --brightness <int> [--tube <1-6>]\n");
+    printf("                                                Set LED backlight color and brightness, all tubes by default\n");
+    printf("set_effect --type <none|breath|rainbow|chase|wave>\n");
+    printf("                                                Set the backlight effect\n");
     printf("set_nixie --number <123456>                     Set nixie digit number, 6 digits\n");
+    printf("set_transition --type <none|fade|roll|scroll> [--ms <n>]\n");
+    printf("                                                Set how nixie digits change, default 150 ms\n");
+    printf("i2c_stats [--reset]                             Show per-device I2C bus usage\n");
+    printf("nixie_stats [--reset]                           Show nixie scan timing and bus cost\n");
+    printf("nixie_cal [--tube <1-6>] [--digit <0-9>] [--level <0-255>] [--save]\n");
+    printf("                                                Show or tune per-cathode nixie drive levels\n");
+    printf("nixie_wear                                      Show per-cathode on-time for cathode care\n");
+    printf("led_stats [--reset]                             Show backlight render cost and frames sent\n");
+    printf("sys_stats [--reset]                             Show system event latency, enqueue to handled\n");
     printf("get_uuid                                        Get UUID of device\n");
     printf("get_hw_version                                  Get hardware version\n");
     printf("get_fw_version                                  Get firmware version\n");
@@ -159,10 +677,15 @@ static int help_func(int argc, char **argv)
     return 0;
 }
 
-CliDaemon::CliDaemon(SystemController &system_controller)
+CliDaemon::CliDaemon(SystemController &system_controller, INixieDriver &nixie_driver,
+                     SettingsStore &settings_store, DisplayDaemon &display_daemon, ILedDriver &led_driver)
     : system_controller_(system_controller), task_handle_(nullptr)
 {
     g_system_controller = &system_controller;
+    g_nixie_driver = &nixie_driver;
+    g_settings_store = &settings_store;
+    g_display_daemon = &display_daemon;
+    g_led_driver = &led_driver;
 }
 
 CliDaemon::~CliDaemon()
@@ -229,6 +752,7 @@ void CliDaemon::register_commands()
     // Register: set_backlight
     backlight_args.rgb = arg_str0(NULL, "rgb", "<r,g,b>", "RGB Color");
     backlight_args.brightness = arg_int0(NULL, "brightness", "<b>", "Brightness");
+    backlight_args.tube = arg_int0(NULL, "tube", "<1-6>", "Tube to set, all if omitted");
     backlight_args.end = arg_end(20);
     const esp_console_cmd_t set_backlight_cmd = {
         .command = "set_backlight",
@@ -239,6 +763,31 @@ void CliDaemon::register_commands()
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&set_backlight_cmd));
 
+    // Register: set_effect
+    effect_args.type = arg_str1(NULL, "type", "<none|breath|rainbow|chase|wave>", "Backlight effect");
+    effect_args.end = arg_end(20);
+    const esp_console_cmd_t set_effect_cmd = {
+        .command = "set_effect",
+        .help = "Set the backlight effect",
+        .hint = NULL,
+        .func = &set_effect_func,
+        .argtable = &effect_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_effect_cmd));
+
+    // Register: set_transition
+    transition_args.type = arg_str1(NULL, "type", "<none|fade|roll|scroll>", "Transition style");
+    transition_args.ms = arg_int0(NULL, "ms", "<n>", "Duration in ms, up to 1000");
+    transition_args.end = arg_end(20);
+    const esp_console_cmd_t set_transition_cmd = {
+        .command = "set_transition",
+        .help = "Set the nixie digit transition",
+        .hint = NULL,
+        .func = &set_transition_func,
+        .argtable = &transition_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&set_transition_cmd));
+
     // Register: ggtool
     const esp_console_cmd_t ggtool = {
         .command = "ggtool",
@@ -249,6 +798,79 @@ void CliDaemon::register_commands()
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&ggtool));
 
+    // Register: i2c_stats
+    i2c_args.reset = arg_lit0(NULL, "reset", "Clear the counters");
+    i2c_args.end = arg_end(20);
+    const esp_console_cmd_t i2c_stats_cmd = {
+        .command = "i2c_stats",
+        .help = "Show I2C bus utilisation and wait times per device",
+        .hint = NULL,
+        .func = &i2c_stats_func,
+        .argtable = &i2c_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&i2c_stats_cmd));
+
+    // Register: nixie_stats
+    scan_args.reset = arg_lit0(NULL, "reset", "Clear the counters");
+    scan_args.end = arg_end(20);
+    const esp_console_cmd_t nixie_stats_cmd = {
+        .command = "nixie_stats",
+        .help = "Show nixie scan slot timing, missed slots and I2C cost per frame",
+        .hint = NULL,
+        .func = &nixie_stats_func,
+        .argtable = &scan_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&nixie_stats_cmd));
+
+    // Register: nixie_cal
+    cal_args.tube = arg_int0(NULL, "tube", "<1-6>", "Tube to tune, all if omitted");
+    cal_args.digit = arg_int0(NULL, "digit", "<0-9>", "Numeral to tune, all if omitted");
+    cal_args.level = arg_int0(NULL, "level", "<0-255>", "Relative drive level, 255 = full");
+    cal_args.save = arg_lit0(NULL, "save", "Persist the calibration to NVS");
+    cal_args.end = arg_end(20);
+    const esp_console_cmd_t nixie_cal_cmd = {
+        .command = "nixie_cal",
+        .help = "Show or tune the per-tube, per-cathode nixie calibration",
+        .hint = NULL,
+        .func = &nixie_cal_func,
+        .argtable = &cal_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&nixie_cal_cmd));
+
+    // Register: nixie_wear
+    const esp_console_cmd_t nixie_wear_cmd = {
+        .command = "nixie_wear",
+        .help = "Show the per-cathode on-time distribution",
+        .hint = NULL,
+        .func = &nixie_wear_func,
+        .argtable = NULL
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&nixie_wear_cmd));
+
+    // Register: led_stats
+    led_args.reset = arg_lit0(NULL, "reset", "Clear the counters");
+    led_args.end = arg_end(20);
+    const esp_console_cmd_t led_stats_cmd = {
+        .command = "led_stats",
+        .help = "Show backlight compositor cost per layer and strip frames sent or skipped",
+        .hint = NULL,
+        .func = &led_stats_func,
+        .argtable = &led_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&led_stats_cmd));
+
+    // Register: sys_stats
+    sys_args.reset = arg_lit0(NULL, "reset", "Clear the counters");
+    sys_args.end = arg_end(20);
+    const esp_console_cmd_t sys_stats_cmd = {
+        .command = "sys_stats",
+        .help = "Show system controller event latency and queue depth",
+        .hint = NULL,
+        .func = &sys_stats_func,
+        .argtable = &sys_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&sys_stats_cmd));
+
     // Register: get_uuid
     const esp_console_cmd_t get_uuid_cmd = {
         .command = "get_uuid",
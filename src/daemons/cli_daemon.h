@@ -4,11 +4,14 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "system_controller.h"
+#include "nixie_driver.h"
+#include "settings_store.h"
 
 class CliDaemon
 {
 public:
-    CliDaemon(SystemController &system_controller);
+    CliDaemon(SystemController &system_controller, INixieDriver &nixie_driver,
+              SettingsStore &settings_store, DisplayDaemon &display_daemon, ILedDriver &led_driver);
     ~CliDaemon();
 
     void start();
@@ -1,47 +1,106 @@
 #include "daemons/display_daemon.h"
 #include "esp_log.h"
-#include <cmath>
+#include "sdkconfig.h"
 #include <algorithm>
 
 static const char *TAG = "DisplayDaemon";
-static constexpr float kTwoPi = 6.28318530718f;
-static constexpr size_t kLedsPerTube = 4;
-static constexpr size_t kTubeCount = 6;
 
-DisplayDaemon::DisplayDaemon(INixieDriver &nixie_driver, ILedDriver &led_driver)
+namespace
+{
+constexpr uint32_t kFrameRateHz = CONFIG_DISPLAY_FRAME_RATE_HZ;
+constexpr uint32_t kFramePeriodUs = 1000000 / kFrameRateHz;
+
+void record(DisplayPhaseTiming &timing, int64_t elapsed_us)
+{
+    timing.last_us = elapsed_us > 0 ? static_cast<uint32_t>(elapsed_us) : 0;
+    timing.max_us = std::max(timing.max_us, timing.last_us);
+    timing.total_us += timing.last_us;
+}
+} // namespace
+
+DisplayDaemon::DisplayDaemon(INixieDriver &nixie_driver, ILedDriver &led_driver, CathodeCare &cathode_care)
     : nixie_driver_(nixie_driver),
       led_driver_(led_driver),
-      queue_(nullptr),
+      cathode_care_(cathode_care),
       task_handle_(nullptr),
-      current_mode_(DisplayMode::CLOCK_HHMMSS),
-      manual_number_(0),
-      current_effect_type_(LedEffectType::BREATH),
-      effect_color_phase_(0.0f),
-      effect_speed_(0.35f),
-      effect_max_brightness_(255),
-      base_backlight_{{0, 255, 255}, 255} // Default Cyan
-{
-    queue_ = xQueueCreate(10, sizeof(DisplayMessage));
+      frame_timer_(nullptr),
+      shown_{},
+      time_valid_(false),
+      current_effect_type_(LedEffectType::NONE),
+      solid_layer_(-1),
+      rainbow_layer_(-1),
+      breath_layer_(-1),
+      dither_(TemporalDither::depth_for_rate(kFrameRateHz))
+{
+    solid_layer_ = compositor_.add_layer(solid_effect_, LedBlend::NORMAL);
+    rainbow_layer_ = compositor_.add_layer(rainbow_effect_, LedBlend::NORMAL, false);
+    breath_layer_ = compositor_.add_layer(breath_effect_, LedBlend::MULTIPLY, false);
+    compositor_.add_layer(battery_bar_effect_, LedBlend::NORMAL);
+    compositor_.add_layer(flash_effect_, LedBlend::NORMAL);
+    // Colours and the effect come from state_'s defaults on the first frame
 }
 
 DisplayDaemon::~DisplayDaemon()
 {
+    if (frame_timer_) {
+        esp_timer_stop(frame_timer_);
+        esp_timer_delete(frame_timer_);
+    }
     if (task_handle_) {
         vTaskDelete(task_handle_);
     }
-    if (queue_) {
-        vQueueDelete(queue_);
-    }
 }
 
 void DisplayDaemon::start()
 {
     xTaskCreate(task_entry, "display_daemon", 4096, this, 5, &task_handle_);
+
+    // The FreeRTOS tick is too coarse for frame deadlines above its rate
+    const esp_timer_create_args_t timer_args = {
+        .callback = on_frame_timer,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "display_frame",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &frame_timer_));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(frame_timer_, kFramePeriodUs));
 }
 
-QueueHandle_t DisplayDaemon::get_queue() const
+void DisplayDaemon::on_frame_timer(void *param)
 {
-    return queue_;
+    auto *daemon = static_cast<DisplayDaemon *>(param);
+    int64_t pending_us = 0;
+    if (!daemon->frame_due_us_.compare_exchange_strong(pending_us, esp_timer_get_time(),
+                                                       std::memory_order_relaxed)) {
+        daemon->dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    xTaskNotifyGive(daemon->task_handle_);
+}
+
+DisplayState &DisplayDaemon::state()
+{
+    return state_;
+}
+
+LedRenderStats DisplayDaemon::get_render_stats() const
+{
+    LedRenderStats stats;
+    render_stats_.read(stats);
+    return stats;
+}
+
+DisplayFrameStats DisplayDaemon::get_frame_stats() const
+{
+    DisplayFrameStats stats;
+    published_frame_stats_.read(stats);
+    return stats;
+}
+
+void DisplayDaemon::reset_render_stats()
+{
+    // Cleared by the display task, which owns the compositor
+    render_stats_reset_requested_ = true;
 }
 
 void DisplayDaemon::task_entry(void *param)
@@ -52,147 +111,159 @@ void DisplayDaemon::task_entry(void *param)
 
 void DisplayDaemon::loop()
 {
-    ESP_LOGI(TAG, "Display Daemon Started");
-    
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t frame_delay = pdMS_TO_TICKS(20); // 50Hz refresh rate
+    ESP_LOGI(TAG, "Display Daemon Started (%lu Hz)", static_cast<unsigned long>(kFrameRateHz));
+
+    // Writes from here on wake the task; earlier ones are still dirty
+    state_.set_reader(xTaskGetCurrentTaskHandle());
+    last_frame_us_ = esp_timer_get_time();
 
     while (true) {
-        DisplayMessage msg;
-        // Non-blocking check for messages
-        while (xQueueReceive(queue_, &msg, 0) == pdTRUE) {
-            process_message(msg);
-        }
+        // Woken by the frame timer or a state write, whichever comes first;
+        // state is applied at once either way
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        // Update Effects
-        update_effects(20); // 20ms dt
+        const int64_t process_start_us = esp_timer_get_time();
+        apply_state();
+        process_us_ += static_cast<uint32_t>(esp_timer_get_time() - process_start_us);
 
-        // Refresh Hardware
-        led_driver_.show();
-        
-        vTaskDelayUntil(&last_wake_time, frame_delay);
+        const int64_t due_us = frame_due_us_.exchange(0, std::memory_order_relaxed);
+        if (due_us != 0) {
+            run_frame(due_us);
+        }
     }
 }
 
-void DisplayDaemon::process_message(const DisplayMessage &msg)
-{
-    switch (msg.command) {
-        case DisplayCmd::UPDATE_TIME:
-            if (current_mode_ == DisplayMode::CLOCK_HHMMSS) {
-                nixie_driver_.display_time(msg.data.time.h, msg.data.time.m, msg.data.time.s);
-            }
-            break;
-        case DisplayCmd::SET_MODE:
-            current_mode_ = msg.data.mode;
-            if (current_mode_ == DisplayMode::MANUAL_DISPLAY) {
-                nixie_driver_.display_number(manual_number_);
-            }
-            break;
-        case DisplayCmd::SET_MANUAL_NUMBER:
-            manual_number_ = msg.data.number;
-            if (current_mode_ == DisplayMode::MANUAL_DISPLAY) {
-                nixie_driver_.display_number(manual_number_);
-            }
-            break;
-        case DisplayCmd::SET_BACKLIGHT_COLOR:
-            base_backlight_.color.hue = 0; // Reset hue if using RGB, but we use HSV internally
-            // Convert RGB to HSV or just use what we have.
-            // The message structure has RGB, but the CLI sends HSV.
-            // Let's assume the message structure was updated or we interpret it.
-            // Wait, message_types.h has RGB in union.
-            // I should have updated message_types.h to support HSV or convert here.
-            // Let's stick to RGB in message for now and convert.
-            {
-                RgbColor rgb = {msg.data.color.r, msg.data.color.g, msg.data.color.b};
-                base_backlight_.color = rgb_to_hsv(rgb);
-            }
-            break;
-        case DisplayCmd::SET_BACKLIGHT_BRIGHTNESS:
-            base_backlight_.brightness = msg.data.brightness;
-            break;
-        case DisplayCmd::SET_EFFECT:
-            if (msg.data.effect_id == 1) {
-                current_effect_type_ = LedEffectType::BREATH;
-                effect_speed_ = 0.35f;
-            } else if (msg.data.effect_id == 2) {
-                current_effect_type_ = LedEffectType::RAINBOW;
-                effect_speed_ = 60.0f;
-            } else {
-                current_effect_type_ = LedEffectType::NONE;
-            }
-            effect_color_phase_ = 0.0f;
-            break;
-        case DisplayCmd::UPDATE_BATTERY:
-            ESP_LOGI(TAG, "Battery Update: %d%%, %d mV, %d mA, SOH: %d%%",
-                     msg.data.battery.soc, msg.data.battery.voltage_mv,
-                     msg.data.battery.current_ma, msg.data.battery.soh);
-            break;
-        default:
-            break;
+void DisplayDaemon::run_frame(int64_t due_us)
+{
+    const int64_t start_us = esp_timer_get_time();
+
+    // Effects advance by the time that really passed; the sub-millisecond
+    // rest is carried so the phases do not drift at high frame rates
+    const uint32_t interval_us = static_cast<uint32_t>(start_us - last_frame_us_);
+    const uint32_t elapsed_us = interval_us + dt_carry_us_;
+    last_frame_us_ = start_us;
+    const uint32_t dt_ms = elapsed_us / 1000;
+    dt_carry_us_ = elapsed_us % 1000;
+
+    // Cathode care borrows the tubes during the off-hours clock only
+    const bool showing_clock = shown_.mode == DisplayMode::CLOCK_HHMMSS && time_valid_;
+    const bool was_caring = cathode_care_.active();
+    const bool caring = cathode_care_.update(pdTICKS_TO_MS(xTaskGetTickCount()),
+                                             showing_clock ? shown_.time.h : -1);
+    if (was_caring && !caring && shown_.mode == DisplayMode::CLOCK_HHMMSS) {
+        nixie_driver_.display_time(shown_.time.h, shown_.time.m, shown_.time.s);
     }
+
+    // Update Effects
+    const int64_t render_start_us = esp_timer_get_time();
+    update_effects(dt_ms);
+
+    // Refresh Hardware; the strip itself skips frames that did not
+    // change, apart from its keep-alive
+    const int64_t show_start_us = esp_timer_get_time();
+    led_driver_.show();
+    const int64_t end_us = esp_timer_get_time();
+
+    if (render_stats_reset_requested_.exchange(false)) {
+        compositor_.reset_stats();
+        frame_stats_ = {};
+    }
+    frame_stats_.rate_hz = kFrameRateHz;
+    frame_stats_.period_us = kFramePeriodUs;
+    frame_stats_.frames++;
+    frame_stats_.dropped += dropped_frames_.exchange(0, std::memory_order_relaxed);
+    if (start_us - due_us >= kFramePeriodUs) {
+        frame_stats_.late++;
+    }
+    frame_stats_.last_dt_us = interval_us;
+    record(frame_stats_.lag, start_us - due_us);
+    record(frame_stats_.process, process_us_);
+    record(frame_stats_.render, show_start_us - render_start_us);
+    record(frame_stats_.show, end_us - show_start_us);
+    process_us_ = 0;
+    render_stats_.publish(compositor_.stats());
+    published_frame_stats_.publish(frame_stats_);
 }
 
-void DisplayDaemon::update_effects(uint32_t dt_ms)
+void DisplayDaemon::apply_state()
 {
-    switch (current_effect_type_) {
-        case LedEffectType::BREATH:
-            run_breath_effect(dt_ms);
-            break;
-        case LedEffectType::RAINBOW:
-            run_rainbow_effect(dt_ms);
-            break;
-        case LedEffectType::NONE:
-        default:
-            break;
+    const uint32_t dirty = state_.take(shown_);
+    if (dirty == 0) {
+        return;
     }
-}
 
-void DisplayDaemon::apply_backlight_to_all(const BackLightState &state)
-{
-    HsvColor adjusted = state.color;
-    uint16_t scaled_value = static_cast<uint16_t>(adjusted.value) * state.brightness / 255;
-    adjusted.value = static_cast<uint8_t>(std::min<uint16_t>(scaled_value, 255));
-    
-    RgbColor rgb = hsv_to_rgb(adjusted);
-    rgb = apply_gamma(rgb);
-
-    // Map tubes to LEDs: Tube i -> LEDs [i*2, i*2+1]
-    for (size_t i = 0; i < kTubeCount; ++i) {
-        for (size_t j = 0; j < kLedsPerTube; ++j) {
-            size_t led_index = i * kLedsPerTube + j;
-            if (led_index < led_driver_.get_led_count()) {
-                led_driver_.set_pixel(led_index, rgb.red, rgb.green, rgb.blue);
-            }
+    if (dirty & display_field_bit(DisplayField::TIME)) {
+        time_valid_ = true;
+    }
+    if (shown_.mode == DisplayMode::MANUAL_DISPLAY) {
+        if (dirty & display_field_bit(DisplayField::MODE)) {
+            nixie_driver_.display_number(shown_.manual_number);
         }
+    } else if (shown_.mode == DisplayMode::CLOCK_HHMMSS && time_valid_ && !cathode_care_.active() &&
+               (dirty & (display_field_bit(DisplayField::TIME) | display_field_bit(DisplayField::MODE)))) {
+        nixie_driver_.display_time(shown_.time.h, shown_.time.m, shown_.time.s);
     }
-}
 
-void DisplayDaemon::run_breath_effect(uint32_t dt_ms)
-{
-    effect_color_phase_ += effect_speed_ * static_cast<float>(dt_ms) * kTwoPi / 1000.0f;
-    if (effect_color_phase_ > kTwoPi)
-    {
-        effect_color_phase_ = std::fmod(effect_color_phase_, kTwoPi);
+    if (dirty & display_field_bit(DisplayField::BACKLIGHT)) {
+        solid_effect_.set_colors(shown_.backlight);
+        rainbow_effect_.set_colors(shown_.backlight);
+    }
+    if (dirty & display_field_bit(DisplayField::EFFECT)) {
+        if (shown_.effect_id == 1) {
+            select_effect(LedEffectType::BREATH);
+        } else if (shown_.effect_id == 2) {
+            select_effect(LedEffectType::RAINBOW);
+        } else if (shown_.effect_id == 3) {
+            select_effect(LedEffectType::RAINBOW_CHASE);
+        } else if (shown_.effect_id == 4) {
+            select_effect(LedEffectType::BREATH_WAVE);
+        } else {
+            select_effect(LedEffectType::NONE);
+        }
+    }
+    if (dirty & display_field_bit(DisplayField::TRANSITION)) {
+        nixie_driver_.set_transition(static_cast<NixieTransition>(shown_.transition.type),
+                                     shown_.transition.duration_ms);
+    }
+    if (dirty & display_field_bit(DisplayField::BATTERY)) {
+        ESP_LOGI(TAG, "Battery Update: %d%%, %d mV, %d mA, SOH: %d%%",
+                 shown_.battery.soc, shown_.battery.voltage_mv,
+                 shown_.battery.current_ma, shown_.battery.soh);
+        battery_bar_effect_.set_level(shown_.battery.soc);
+    }
+    if (dirty & display_field_bit(DisplayField::FLASH)) {
+        flash_effect_.trigger(shown_.flash.color, shown_.flash.count);
     }
+}
 
-    float normalized = (std::sin(effect_color_phase_) + 1.0f) * 0.5f;
-    
-    BackLightState current_state = base_backlight_;
-    current_state.brightness = static_cast<uint8_t>(std::round(normalized * effect_max_brightness_));
+void DisplayDaemon::select_effect(LedEffectType type)
+{
+    // Group effects step one tube at a time through a whole cycle
+    constexpr uint16_t kTubeStepDegrees = 360 / kNixieTubeCount;
+    const bool rainbow = type == LedEffectType::RAINBOW || type == LedEffectType::RAINBOW_CHASE;
+    const bool breath = type == LedEffectType::BREATH || type == LedEffectType::BREATH_WAVE;
 
-    apply_backlight_to_all(current_state);
+    current_effect_type_ = type;
+    rainbow_effect_.set_spread(type == LedEffectType::RAINBOW_CHASE ? kTubeStepDegrees : 0);
+    breath_effect_.set_phase_step(type == LedEffectType::BREATH_WAVE ? kTubeStepDegrees : 0);
+    compositor_.set_enabled(solid_layer_, !rainbow);
+    compositor_.set_enabled(rainbow_layer_, rainbow);
+    compositor_.set_enabled(breath_layer_, breath);
 }
 
-void DisplayDaemon::run_rainbow_effect(uint32_t dt_ms)
+void DisplayDaemon::update_effects(uint32_t dt_ms)
 {
-    effect_color_phase_ += effect_speed_ * static_cast<float>(dt_ms) / 1000.0f;
-    if (effect_color_phase_ >= 360.0f)
-    {
-        effect_color_phase_ = std::fmod(effect_color_phase_, 360.0f);
+    // A new frame restarts dithering; a frame with no fractions is written
+    // once and then left to the strip's unchanged-frame skipping
+    if (compositor_.render(dt_ms)) {
+        dithering_ = true;
     }
-
-    BackLightState current_state = base_backlight_;
-    current_state.color.hue = static_cast<uint16_t>(effect_color_phase_) % 360;
-    
-    apply_backlight_to_all(current_state);
-}
\ No newline at end of file
+    if (dithering_) {
+        dithering_ = dither_.apply(compositor_.output(), dithered_);
+        // Map tubes to LEDs: Tube i -> the board's LEDs [i*n, (i+1)*n),
+        // so the planes go out in one bulk write
+        size_t led_count = std::min(kBacklightLedCount, led_driver_.get_led_count());
+        led_driver_.set_pixels(0, dithered_.red.data(), dithered_.green.data(), dithered_.blue.data(),
+                               led_count);
+    }
+}
@@ -1,52 +1,113 @@
 #pragma once
 
+#include <atomic>
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "message_types.h"
 #include "nixie_driver.h"
 #include "led_driver.h"
+#include "cathode_care.h"
+#include "frame_buffer.h"
+#include "led_compositor.h"
+#include "led_effects.h"
+#include "temporal_dither.h"
+#include "display_state.h"
 
 enum class LedEffectType
 {
     NONE,
     BREATH,
-    RAINBOW
+    RAINBOW,
+    RAINBOW_CHASE, // rainbow with each tube a step further round the wheel
+    BREATH_WAVE    // breath with each tube lagging the one before
+};
+
+// Time spent in one part of the frame
+struct DisplayPhaseTiming
+{
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+};
+
+struct DisplayFrameStats
+{
+    uint32_t rate_hz;
+    uint32_t period_us; // the budget every frame has to fit in
+    uint32_t frames;
+    uint32_t late;        // frames started a whole period or more after their deadline
+    uint32_t dropped;     // deadlines that passed while an earlier one still waited
+    DisplayPhaseTiming lag;     // deadline to frame start
+    DisplayPhaseTiming process; // applying state, over the frame and the wait before it
+    DisplayPhaseTiming render;  // effects, compositing and dithering
+    DisplayPhaseTiming show;    // handing the frame to the strip
+    uint32_t last_dt_us;        // measured time between the last two frames
 };
 
 class DisplayDaemon
 {
 public:
-    DisplayDaemon(INixieDriver &nixie_driver, ILedDriver &led_driver);
+    DisplayDaemon(INixieDriver &nixie_driver, ILedDriver &led_driver, CathodeCare &cathode_care);
     ~DisplayDaemon();
 
     void start();
-    QueueHandle_t get_queue() const;
+    // What to show; written by any task, applied by the display task
+    DisplayState &state();
+    // Backlight render cost; safe to call from any task
+    LedRenderStats get_render_stats() const;
+    // Frame pacing and where each frame's time goes; safe to call from any
+    // task. reset_render_stats() clears these too.
+    DisplayFrameStats get_frame_stats() const;
+    void reset_render_stats();
 
 private:
     static void task_entry(void *param);
+    static void on_frame_timer(void *param);
     void loop();
-    void process_message(const DisplayMessage &msg);
+    void run_frame(int64_t due_us);
+    // Applies whatever was written to state_ since the last call
+    void apply_state();
+    void select_effect(LedEffectType type);
     void update_effects(uint32_t dt_ms);
 
-    // Effect implementations
-    void run_breath_effect(uint32_t dt_ms);
-    void run_rainbow_effect(uint32_t dt_ms);
-    void apply_backlight_to_all(const BackLightState &state);
-
     INixieDriver &nixie_driver_;
     ILedDriver &led_driver_;
-    QueueHandle_t queue_;
+    CathodeCare &cathode_care_;
     TaskHandle_t task_handle_;
+    // Paces the frames: each expiry stamps the deadline and wakes the task,
+    // which also wakes for state writes in between. The oldest unserved
+    // deadline stays, so the lag shows how late the task really is; later
+    // expiries only count as dropped.
+    esp_timer_handle_t frame_timer_;
+    std::atomic<int64_t> frame_due_us_{0};
+    std::atomic<uint32_t> dropped_frames_{0};
+    int64_t last_frame_us_ = 0;
+    uint32_t dt_carry_us_ = 0;
+    uint32_t process_us_ = 0; // since the last frame
+    DisplayFrameStats frame_stats_{};
 
     // State
-    DisplayMode current_mode_;
-    uint32_t manual_number_;
+    DisplayState state_;
+    DisplayStateData shown_;
+    bool time_valid_;
     LedEffectType current_effect_type_;
-    
-    // Effect parameters
-    float effect_color_phase_;
-    float effect_speed_;
-    uint8_t effect_max_brightness_;
-    BackLightState base_backlight_;
+
+    // Backlight layers, bottom-up: one base colour, then modulation and
+    // overlays
+    LedCompositor compositor_;
+    SolidColorEffect solid_effect_;
+    RainbowEffect rainbow_effect_;
+    BreathEffect breath_effect_;
+    BatteryBarEffect battery_bar_effect_;
+    FlashEffect flash_effect_;
+    int solid_layer_;
+    int rainbow_layer_;
+    int breath_layer_;
+    TemporalDither dither_;
+    LedOutput dithered_;
+    bool dithering_ = false;
+    FrameBuffer<LedRenderStats> render_stats_;
+    FrameBuffer<DisplayFrameStats> published_frame_stats_;
+    std::atomic<bool> render_stats_reset_requested_{false};
 };
\ No newline at end of file
@@ -50,7 +50,7 @@ void GasgaugeDaemon::loop()
             msg.data.battery = data;
             
             // Use a timeout of 0 to avoid blocking if queue is full
-            if (xQueueSend(system_queue_, &msg, 0) != pdTRUE) {
+            if (post_system_message(system_queue_, msg) != pdTRUE) {
                 ESP_LOGW(TAG, "System queue full, dropped battery update");
             }
         } else {
@@ -48,7 +48,7 @@ void PowerDaemon::loop()
             msg.event = SystemEvent::POWER_UPDATE;
             msg.data.power = data;
             
-            if (xQueueSend(system_queue_, &msg, 0) != pdTRUE) {
+            if (post_system_message(system_queue_, msg) != pdTRUE) {
                 ESP_LOGW(TAG, "System queue full, dropped power update");
             }
         } else {
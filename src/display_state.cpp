@@ -0,0 +1,123 @@
+#include "display_state.h"
+#include "esp_log.h"
+
+static const char *TAG = "DisplayState";
+
+DisplayState::DisplayState()
+{
+    state_.mode = DisplayMode::CLOCK_HHMMSS;
+    state_.backlight.fill({{0, 255, 255}, 255}); // Default Cyan
+    state_.effect_id = 1;                        // Breath
+    // What the reader has to set up before its first frame; time, battery
+    // and flash only count once written
+    dirty_ = display_field_bit(DisplayField::MODE) | display_field_bit(DisplayField::BACKLIGHT) |
+             display_field_bit(DisplayField::EFFECT);
+}
+
+template <typename Update>
+void DisplayState::write(DisplayField field, Update update)
+{
+    const uint32_t bit = display_field_bit(field);
+    taskENTER_CRITICAL(&lock_);
+    update(state_);
+    state_.versions[static_cast<size_t>(field)]++;
+    stats_.writes++;
+    if (dirty_ & bit) {
+        stats_.coalesced++;
+    }
+    dirty_ |= bit;
+    TaskHandle_t reader = reader_;
+    taskEXIT_CRITICAL(&lock_);
+
+    if (reader) {
+        xTaskNotifyGive(reader);
+    }
+}
+
+void DisplayState::set_time(uint8_t h, uint8_t m, uint8_t s)
+{
+    write(DisplayField::TIME, [&](DisplayStateData &state) { state.time = {h, m, s}; });
+}
+
+void DisplayState::set_mode(DisplayMode mode)
+{
+    write(DisplayField::MODE, [&](DisplayStateData &state) { state.mode = mode; });
+}
+
+void DisplayState::show_number(uint32_t number)
+{
+    write(DisplayField::MODE, [&](DisplayStateData &state) {
+        state.mode = DisplayMode::MANUAL_DISPLAY;
+        state.manual_number = number;
+    });
+}
+
+void DisplayState::set_backlight(int tube, const RgbColor *color, const uint8_t *brightness)
+{
+    if (tube >= static_cast<int>(kNixieTubeCount)) {
+        ESP_LOGW(TAG, "No tube %d to set the backlight of", tube + 1);
+        return;
+    }
+    // The state is kept as HSV; convert outside the lock
+    const HsvColor hsv = color ? rgb_to_hsv(*color) : HsvColor{};
+    write(DisplayField::BACKLIGHT, [&](DisplayStateData &state) {
+        const size_t first = tube < 0 ? 0 : static_cast<size_t>(tube);
+        const size_t last = tube < 0 ? state.backlight.size() - 1 : first;
+        for (size_t i = first; i <= last; ++i) {
+            if (color) {
+                state.backlight[i].color = hsv;
+            }
+            if (brightness) {
+                state.backlight[i].brightness = *brightness;
+            }
+        }
+    });
+}
+
+void DisplayState::set_effect(uint8_t effect_id)
+{
+    write(DisplayField::EFFECT, [&](DisplayStateData &state) { state.effect_id = effect_id; });
+}
+
+void DisplayState::set_transition(uint8_t type, uint16_t duration_ms)
+{
+    write(DisplayField::TRANSITION, [&](DisplayStateData &state) { state.transition = {type, duration_ms}; });
+}
+
+void DisplayState::set_battery(const GasgaugeData &battery)
+{
+    write(DisplayField::BATTERY, [&](DisplayStateData &state) { state.battery = battery; });
+}
+
+void DisplayState::flash(const RgbColor &color, uint8_t count)
+{
+    write(DisplayField::FLASH, [&](DisplayStateData &state) { state.flash = {color, count}; });
+}
+
+void DisplayState::set_reader(TaskHandle_t task)
+{
+    taskENTER_CRITICAL(&lock_);
+    reader_ = task;
+    taskEXIT_CRITICAL(&lock_);
+}
+
+uint32_t DisplayState::take(DisplayStateData &out)
+{
+    taskENTER_CRITICAL(&lock_);
+    const uint32_t dirty = dirty_;
+    if (dirty) {
+        out = state_;
+        dirty_ = 0;
+        stats_.takes++;
+    }
+    taskEXIT_CRITICAL(&lock_);
+    return dirty;
+}
+
+DisplayStateStats DisplayState::stats() const
+{
+    taskENTER_CRITICAL(&lock_);
+    const DisplayStateStats stats = stats_;
+    taskEXIT_CRITICAL(&lock_);
+    return stats;
+}
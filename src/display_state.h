@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "message_types.h"
+#include "led_effects.h"
+
+enum class DisplayField : uint8_t
+{
+    TIME,
+    MODE,           // mode and manual number
+    BACKLIGHT,
+    EFFECT,
+    TRANSITION,
+    BATTERY,
+    FLASH
+};
+
+constexpr size_t kDisplayFieldCount = static_cast<size_t>(DisplayField::FLASH) + 1;
+
+constexpr uint32_t display_field_bit(DisplayField field)
+{
+    return 1u << static_cast<uint32_t>(field);
+}
+
+struct DisplayStateData
+{
+    struct
+    {
+        uint8_t h, m, s;
+    } time;
+    DisplayMode mode;
+    uint32_t manual_number;
+    TubeBacklight backlight;
+    uint8_t effect_id; // 0: None, 1: Breath, 2: Rainbow, 3: Rainbow chase, 4: Breath wave
+    struct
+    {
+        uint8_t type; // NixieTransition
+        uint16_t duration_ms;
+    } transition;
+    GasgaugeData battery;
+    struct
+    {
+        RgbColor color;
+        uint8_t count;
+    } flash; // a new FLASH version starts it again
+    // Bumped by every write of the field, by DisplayField
+    std::array<uint32_t, kDisplayFieldCount> versions;
+};
+
+struct DisplayStateStats
+{
+    uint32_t writes;
+    uint32_t coalesced; // writes to a field that was still dirty
+    uint32_t takes;     // take() calls that found something dirty
+};
+
+// Latest-value store between the tasks that change what is shown and the
+// DisplayDaemon. A write replaces its field, marks it dirty and wakes the
+// reader with a task notification; the reader takes a snapshot and the dirty
+// mask together. A burst of writes therefore collapses into one update, and
+// there is no queue to fill up and drop from.
+//
+// Writers may be any task. The lock is a short critical section around a
+// copy, like the driver's calibration lock.
+class DisplayState
+{
+public:
+    DisplayState();
+
+    void set_time(uint8_t h, uint8_t m, uint8_t s);
+    void set_mode(DisplayMode mode);
+    // Switches to MANUAL_DISPLAY showing number, as one write
+    void show_number(uint32_t number);
+    // tube < 0 sets every tube; a null color or brightness is left as it is
+    void set_backlight(int tube, const RgbColor *color, const uint8_t *brightness);
+    void set_effect(uint8_t effect_id);
+    void set_transition(uint8_t type, uint16_t duration_ms);
+    void set_battery(const GasgaugeData &battery);
+    void flash(const RgbColor &color, uint8_t count);
+
+    // The task to notify on writes. Writes before it is set stay dirty and
+    // are picked up by its first take().
+    void set_reader(TaskHandle_t task);
+    // Returns the display_field_bit()s written since the last take and clears
+    // them; when any were, out gets a copy of the whole state
+    uint32_t take(DisplayStateData &out);
+
+    DisplayStateStats stats() const;
+
+private:
+    template <typename Update>
+    void write(DisplayField field, Update update);
+
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    DisplayStateData state_{};
+    uint32_t dirty_ = 0;
+    TaskHandle_t reader_ = nullptr;
+    DisplayStateStats stats_{};
+};
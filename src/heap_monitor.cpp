@@ -0,0 +1,75 @@
+#include "heap_monitor.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <atomic>
+
+namespace
+{
+TaskHandle_t g_watched_tasks[HeapMonitor::kMaxWatchedTasks] = {};
+volatile uint32_t g_task_allocations[HeapMonitor::kMaxWatchedTasks] = {};
+std::atomic<uint32_t> g_total_allocations{0};
+portMUX_TYPE g_watch_lock = portMUX_INITIALIZER_UNLOCKED;
+} // namespace
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    g_total_allocations.fetch_add(1, std::memory_order_relaxed);
+    const TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (int slot = 0; slot < HeapMonitor::kMaxWatchedTasks; ++slot) {
+        if (g_watched_tasks[slot] == current) {
+            // Only the watched task itself ever increments its slot
+            g_task_allocations[slot] = g_task_allocations[slot] + 1;
+            break;
+        }
+    }
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+{
+}
+#endif
+
+int HeapMonitor::watch_current_task()
+{
+    const TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    int result = -1;
+    taskENTER_CRITICAL(&g_watch_lock);
+    for (int slot = 0; slot < kMaxWatchedTasks; ++slot) {
+        if (g_watched_tasks[slot] == current) {
+            result = slot;
+            break;
+        }
+        if (!g_watched_tasks[slot] && result < 0) {
+            result = slot;
+        }
+    }
+    if (result >= 0 && g_watched_tasks[result] != current) {
+        g_task_allocations[result] = 0;
+        g_watched_tasks[result] = current;
+    }
+    taskEXIT_CRITICAL(&g_watch_lock);
+    return result;
+}
+
+uint32_t HeapMonitor::allocation_count(int slot)
+{
+    if (slot < 0 || slot >= kMaxWatchedTasks) {
+        return 0;
+    }
+    return g_task_allocations[slot];
+}
+
+uint32_t HeapMonitor::total_allocations()
+{
+    return g_total_allocations.load(std::memory_order_relaxed);
+}
+
+bool HeapMonitor::enabled()
+{
+#ifdef CONFIG_HEAP_USE_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
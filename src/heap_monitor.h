@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Counts heap allocations per task through the CONFIG_HEAP_USE_HOOKS callbacks,
+// so hot loops can show that they stay allocation-free. Without the hooks
+// enabled every count reads zero.
+class HeapMonitor
+{
+public:
+    static constexpr int kMaxWatchedTasks = 4;
+
+    // Start counting allocations made by the calling task. Returns the slot
+    // to pass to allocation_count(), or -1 if all slots are taken.
+    static int watch_current_task();
+    static uint32_t allocation_count(int slot);
+    static uint32_t total_allocations();
+    static bool enabled();
+};
@@ -0,0 +1,197 @@
+#include "hv57708_nixie_driver.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+namespace
+{
+// Defaults are the FSPI IO_MUX pins, so the quad data lines skip the GPIO
+// matrix. The Kconfig values only exist with the HV57708 backend selected.
+constexpr spi_host_device_t kSpiHost = SPI2_HOST;
+#ifdef CONFIG_NIXIE_BACKEND_HV57708
+constexpr Hv57708Pins kPins = {
+    .clk = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_CLK),
+    .din1 = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_DIN1),
+    .din2 = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_DIN2),
+    .din3 = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_DIN3),
+    .din4 = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_DIN4),
+    .le = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_LE),
+    .bl = static_cast<gpio_num_t>(CONFIG_HV57708_PIN_BL),
+};
+#else
+constexpr Hv57708Pins kPins = {
+    .clk = static_cast<gpio_num_t>(12),
+    .din1 = static_cast<gpio_num_t>(11),
+    .din2 = static_cast<gpio_num_t>(13),
+    .din3 = static_cast<gpio_num_t>(14),
+    .din4 = static_cast<gpio_num_t>(9),
+    .le = static_cast<gpio_num_t>(10),
+    .bl = static_cast<gpio_num_t>(21),
+};
+#endif
+
+constexpr int kSpiClockHz = 8000000;        // 2 us per frame, well under the 32 MHz limit
+constexpr uint32_t kBlPwmFrequencyHz = 25000;
+
+const char *kTag = "Hv57708Nixie";
+} // namespace
+
+Hv57708NixieDriver::Hv57708NixieDriver()
+    : chip_(kSpiHost, kPins)
+{
+}
+
+void Hv57708NixieDriver::display_time(uint8_t h, uint8_t m, uint8_t s)
+{
+    set_digits({static_cast<uint8_t>(h / 10), static_cast<uint8_t>(h % 10),
+                static_cast<uint8_t>(m / 10), static_cast<uint8_t>(m % 10),
+                static_cast<uint8_t>(s / 10), static_cast<uint8_t>(s % 10)});
+}
+
+void Hv57708NixieDriver::display_number(uint32_t number)
+{
+    NixieDigits digits{};
+    for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i) {
+        digits[static_cast<size_t>(i)] = number % 10;
+        number /= 10;
+    }
+    set_digits(digits);
+}
+
+void Hv57708NixieDriver::set_brightness(uint8_t brightness)
+{
+    taskENTER_CRITICAL(&wear_lock_);
+    account_wear();
+    brightness_ = brightness;
+    taskEXIT_CRITICAL(&wear_lock_);
+    if (ready_) {
+        chip_.set_brightness(brightness_);
+    }
+}
+
+void Hv57708NixieDriver::set_digits(const NixieDigits &digits)
+{
+    taskENTER_CRITICAL(&wear_lock_);
+    account_wear();
+    digit_cache_ = digits;
+    taskEXIT_CRITICAL(&wear_lock_);
+    for (size_t i = 0; i < tubes_.size(); ++i) {
+        tubes_[i].set_numeral(digit_cache_[i]);
+    }
+    write_frame();
+}
+
+void Hv57708NixieDriver::nixie_scan_start(i2c_port_t i2c_port)
+{
+    (void)i2c_port;
+    if (ready_) {
+        return;
+    }
+    if (!chip_.init(kSpiClockHz, kBlPwmFrequencyHz)) {
+        ESP_LOGE(kTag, "Failed to init HV57708");
+        return;
+    }
+    taskENTER_CRITICAL(&wear_lock_);
+    wear_last_us_ = esp_timer_get_time();
+    ready_ = true;
+    taskEXIT_CRITICAL(&wear_lock_);
+    write_frame();
+    chip_.set_brightness(brightness_);
+}
+
+std::vector<NixieTube *> Hv57708NixieDriver::get_tubes()
+{
+    std::vector<NixieTube *> ptrs;
+    ptrs.reserve(tubes_.size());
+    for (auto &tube : tubes_) {
+        ptrs.push_back(&tube);
+    }
+    return ptrs;
+}
+
+NixieScanStats Hv57708NixieDriver::get_scan_stats() const
+{
+    return stats_;
+}
+
+void Hv57708NixieDriver::reset_scan_stats()
+{
+    stats_ = {};
+}
+
+void Hv57708NixieDriver::set_transition(NixieTransition transition, uint16_t duration_ms)
+{
+    (void)transition;
+    (void)duration_ms;
+}
+
+void Hv57708NixieDriver::set_calibration(const NixieCalibration &calibration)
+{
+    taskENTER_CRITICAL(&calibration_lock_);
+    calibration_ = calibration;
+    taskEXIT_CRITICAL(&calibration_lock_);
+}
+
+NixieCalibration Hv57708NixieDriver::get_calibration() const
+{
+    taskENTER_CRITICAL(&calibration_lock_);
+    NixieCalibration copy = calibration_;
+    taskEXIT_CRITICAL(&calibration_lock_);
+    return copy;
+}
+
+NixieWear Hv57708NixieDriver::get_wear() const
+{
+    taskENTER_CRITICAL(&wear_lock_);
+    account_wear();
+    NixieWear copy = wear_counter_.seconds();
+    taskEXIT_CRITICAL(&wear_lock_);
+    return copy;
+}
+
+bool Hv57708NixieDriver::restore_wear(const NixieWear &wear)
+{
+    taskENTER_CRITICAL(&wear_lock_);
+    const bool idle = !ready_;
+    if (idle) {
+        wear_counter_.restore(wear);
+    }
+    taskEXIT_CRITICAL(&wear_lock_);
+    return idle;
+}
+
+void Hv57708NixieDriver::account_wear() const
+{
+    if (!ready_) {
+        return;
+    }
+    const int64_t now_us = esp_timer_get_time();
+    const uint32_t elapsed_ms = static_cast<uint32_t>((now_us - wear_last_us_) / 1000);
+    if (elapsed_ms == 0) {
+        return;
+    }
+    wear_last_us_ += static_cast<int64_t>(elapsed_ms) * 1000;
+    if (brightness_ == 0) {
+        return;
+    }
+    for (size_t tube = 0; tube < digit_cache_.size(); ++tube) {
+        if (digit_cache_[tube] < 10) {
+            wear_counter_.add(tube, digit_cache_[tube], elapsed_ms);
+        }
+    }
+}
+
+void Hv57708NixieDriver::write_frame()
+{
+    if (!ready_) {
+        return;
+    }
+    if (!chip_.write(hv57708_digit_outputs(digit_cache_))) {
+        ESP_LOGW(kTag, "Frame write failed");
+        return;
+    }
+    // There is no scan, so a "frame" is one latched update and the slot
+    // counters stay at zero. Bytes are SPI bytes, not I2C.
+    stats_.frames++;
+    stats_.last_frame_bytes = Hv57708::kFrameBytes;
+    stats_.max_frame_bytes = Hv57708::kFrameBytes;
+}
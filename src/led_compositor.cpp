@@ -0,0 +1,154 @@
+#include "led_compositor.h"
+#include "esp_timer.h"
+#include <algorithm>
+
+namespace
+{
+inline void blend_plane(LedBlend mode, const std::array<uint16_t, kBacklightLedCount> &layer,
+                        const std::array<uint8_t, kBacklightLedCount> &alpha,
+                        std::array<uint16_t, kBacklightLedCount> &out)
+{
+    for (size_t i = 0; i < out.size(); ++i) {
+        const uint32_t a = alpha[i];
+        if (a == 0) {
+            continue;
+        }
+        switch (mode) {
+            case LedBlend::NORMAL:
+                out[i] = static_cast<uint16_t>((out[i] * (255 - a) + layer[i] * a + 127) / 255);
+                break;
+            case LedBlend::MULTIPLY: {
+                // Uncovered pixels multiply by 1, covered ones by the layer
+                const uint32_t factor = (kColor16Max * (255 - a) + layer[i] * a + 127) / 255;
+                out[i] = static_cast<uint16_t>((out[i] * factor + kColor16Max / 2) / kColor16Max);
+                break;
+            }
+            case LedBlend::ADD:
+                out[i] = static_cast<uint16_t>(
+                    std::min<uint32_t>(kColor16Max, out[i] + (layer[i] * a + 127) / 255));
+                break;
+        }
+    }
+}
+} // namespace
+
+int LedCompositor::add_layer(ILedEffect &effect, LedBlend blend, bool enabled)
+{
+    if (layer_count_ == layers_.size()) {
+        return -1;
+    }
+    Layer &layer = layers_[layer_count_];
+    layer.effect = &effect;
+    layer.blend = blend;
+    layer.enabled = enabled;
+    layer.dirty = true;
+    LedLayerStats &stats = stats_.layers[layer_count_];
+    stats = {};
+    stats.name = effect.name();
+    stats.blend = blend;
+    stats.enabled = enabled;
+    stats_.layer_count = ++layer_count_;
+    return static_cast<int>(layer_count_ - 1);
+}
+
+bool LedCompositor::valid(int layer) const
+{
+    return layer >= 0 && static_cast<size_t>(layer) < layer_count_;
+}
+
+void LedCompositor::set_enabled(int layer, bool enabled)
+{
+    if (!valid(layer) || layers_[layer].enabled == enabled) {
+        return;
+    }
+    Layer &entry = layers_[layer];
+    entry.enabled = enabled;
+    stats_.layers[layer].enabled = enabled;
+    if (enabled) {
+        entry.effect->restart();
+        entry.dirty = true;
+    } else {
+        stack_dirty_ = true;
+    }
+}
+
+bool LedCompositor::enabled(int layer) const
+{
+    return valid(layer) && layers_[layer].enabled;
+}
+
+bool LedCompositor::render(uint32_t dt_ms)
+{
+    const int64_t start_us = esp_timer_get_time();
+    stats_.frames++;
+
+    bool changed = stack_dirty_;
+    for (size_t i = 0; i < layer_count_; ++i) {
+        Layer &layer = layers_[i];
+        if (!layer.enabled) {
+            continue;
+        }
+        const int64_t layer_start_us = esp_timer_get_time();
+        if (layer.effect->advance(dt_ms) || layer.dirty) {
+            layer.effect->draw(layer.frame);
+            layer.dirty = true;
+            stats_.layers[i].draws++;
+            changed = true;
+        }
+        LedLayerStats &stats = stats_.layers[i];
+        stats.last_us = static_cast<uint32_t>(esp_timer_get_time() - layer_start_us);
+        stats.max_us = std::max(stats.max_us, stats.last_us);
+    }
+    if (!changed) {
+        return false;
+    }
+
+    output_ = {};
+    for (size_t i = 0; i < layer_count_; ++i) {
+        Layer &layer = layers_[i];
+        if (!layer.enabled) {
+            continue;
+        }
+        blend(layer.blend, layer.frame, output_);
+        layer.dirty = false;
+    }
+    stack_dirty_ = false;
+
+    const uint32_t elapsed_us = static_cast<uint32_t>(esp_timer_get_time() - start_us);
+    stats_.composed++;
+    stats_.last_us = elapsed_us;
+    stats_.max_us = std::max(stats_.max_us, elapsed_us);
+    stats_.total_us += elapsed_us;
+    return true;
+}
+
+const LedPixels &LedCompositor::output() const
+{
+    return output_;
+}
+
+const LedRenderStats &LedCompositor::stats() const
+{
+    return stats_;
+}
+
+void LedCompositor::reset_stats()
+{
+    stats_.frames = 0;
+    stats_.composed = 0;
+    stats_.last_us = 0;
+    stats_.max_us = 0;
+    stats_.total_us = 0;
+    for (size_t i = 0; i < layer_count_; ++i) {
+        stats_.layers[i].draws = 0;
+        stats_.layers[i].last_us = 0;
+        stats_.layers[i].max_us = 0;
+    }
+}
+
+void LedCompositor::blend(LedBlend mode, const LedLayerFrame &layer, LedPixels &out)
+{
+    blend_plane(mode, layer.color.red, layer.alpha, out.red);
+    blend_plane(mode, layer.color.green, layer.alpha, out.green);
+    blend_plane(mode, layer.color.blue, layer.alpha, out.blue);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "board_profile.h"
+#include "color_model.h"
+
+// Gamma-corrected 8.8 drive levels; TemporalDither brings them to 8 bits
+using LedPixels = RgbFrame16<kBacklightLedCount>;
+
+// One layer's pixels plus how much of each pixel the layer covers
+// (0 = transparent, 255 = opaque)
+struct LedLayerFrame
+{
+    LedPixels color;
+    std::array<uint8_t, kBacklightLedCount> alpha{};
+};
+
+enum class LedBlend : uint8_t
+{
+    NORMAL,   // covers the layers below by alpha
+    MULTIPLY, // scales the layers below, for brightness modulation
+    ADD       // lightens the layers below, saturating
+};
+
+// Effect plugin. advance() moves the effect on by dt_ms and says whether its
+// pixels changed; draw() is only called when they did, or when the layer is
+// switched back on, so an idle effect costs one call per frame.
+class ILedEffect
+{
+public:
+    virtual ~ILedEffect() = default;
+
+    virtual const char *name() const = 0;
+    virtual bool advance(uint32_t dt_ms) = 0;
+    virtual void draw(LedLayerFrame &frame) = 0;
+    // Called when the layer is switched on, so it starts from its first frame
+    virtual void restart() {}
+};
+
+constexpr size_t kMaxLedLayers = 6;
+
+struct LedLayerStats
+{
+    const char *name;
+    LedBlend blend;
+    bool enabled;
+    uint32_t draws;
+    uint32_t last_us; // advance + draw, last frame it was enabled
+    uint32_t max_us;
+};
+
+struct LedRenderStats
+{
+    uint32_t frames;   // render() calls
+    uint32_t composed; // frames where a layer changed and the output was rebuilt
+    uint32_t last_us;  // whole render() of the last composed frame
+    uint32_t max_us;
+    uint64_t total_us; // over composed frames
+    size_t layer_count;
+    std::array<LedLayerStats, kMaxLedLayers> layers;
+};
+
+// Stacks effect layers bottom-up over black. Each layer keeps its last frame
+// and a dirty flag; the output is only rebuilt when some layer changed or was
+// switched on or off. Not thread-safe: owned by one task.
+class LedCompositor
+{
+public:
+    // Registers effect as the next layer up; returns its index, or -1 when
+    // all kMaxLedLayers are taken
+    int add_layer(ILedEffect &effect, LedBlend blend, bool enabled = true);
+    void set_enabled(int layer, bool enabled);
+    bool enabled(int layer) const;
+
+    // Advances every enabled effect and recomposites if any changed.
+    // Returns true when output() holds a new frame.
+    bool render(uint32_t dt_ms);
+    const LedPixels &output() const;
+
+    const LedRenderStats &stats() const;
+    void reset_stats();
+
+    static void blend(LedBlend mode, const LedLayerFrame &layer, LedPixels &out);
+
+private:
+    struct Layer
+    {
+        ILedEffect *effect = nullptr;
+        LedBlend blend = LedBlend::NORMAL;
+        bool enabled = false;
+        bool dirty = false;
+        LedLayerFrame frame;
+    };
+
+    bool valid(int layer) const;
+
+    std::array<Layer, kMaxLedLayers> layers_{};
+    size_t layer_count_ = 0;
+    // A layer went off: nothing of its own is dirty but the stack changed
+    bool stack_dirty_ = true;
+    LedPixels output_;
+    LedRenderStats stats_{};
+};
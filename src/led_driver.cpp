@@ -1,9 +1,12 @@
 #include "led_driver.h"
 #include "ws2812.h"
+#include "board_profile.h"
+#include "sdkconfig.h"
 
-LedDriver::LedDriver(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t copy_encoder)
-    : strip_(new Ws2812Strip(tx_channel, copy_encoder))
+LedDriver::LedDriver(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder)
+    : strip_(new Ws2812Strip(tx_channel, encoder, kBacklightLedCount, kBacklightLedsPerTube))
 {
+    strip_->set_keepalive(CONFIG_WS2812_KEEPALIVE_MS);
 }
 
 LedDriver::~LedDriver()
@@ -21,11 +24,32 @@ esp_err_t LedDriver::set_pixel(std::size_t index, uint8_t red, uint8_t green, ui
     return strip_->set_pixel(index, red, green, blue);
 }
 
+esp_err_t LedDriver::set_group(std::size_t tube, uint8_t red, uint8_t green, uint8_t blue)
+{
+    return strip_->set_group(tube, red, green, blue);
+}
+
+esp_err_t LedDriver::set_pixels(std::size_t first, const uint8_t *red, const uint8_t *green,
+                                const uint8_t *blue, std::size_t count)
+{
+    return strip_->set_pixels(first, red, green, blue, count);
+}
+
 esp_err_t LedDriver::show()
 {
     return strip_->show();
 }
 
+LedShowStats LedDriver::get_show_stats() const
+{
+    return {strip_->transmitted_frames(), strip_->skipped_frames(), strip_->keepalive_frames()};
+}
+
+void LedDriver::reset_show_stats()
+{
+    strip_->reset_frame_counters();
+}
+
 esp_err_t LedDriver::fill(uint8_t red, uint8_t green, uint8_t blue)
 {
     return strip_->fill(red, green, blue);
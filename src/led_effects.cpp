@@ -0,0 +1,254 @@
+#include "led_effects.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr float kTwoPi = 6.28318530718f;
+
+constexpr uint32_t kFlashPeriodMs = 400;
+constexpr uint32_t kBatteryShowMs = 3000;
+constexpr uint32_t kBatteryFadeMs = 500;
+constexpr uint16_t kBatteryFullHue = 120; // green; empty is red
+
+uint8_t scaled_value(const BackLightState &state)
+{
+    return static_cast<uint8_t>(static_cast<uint16_t>(state.color.value) * state.brightness / 255);
+}
+
+// Gamma-corrects rgb into the layer's 8.8 planes
+void fill_solid(LedLayerFrame &frame, const RgbColor &rgb, uint8_t alpha)
+{
+    frame.color.red.fill(gamma16(rgb.red));
+    frame.color.green.fill(gamma16(rgb.green));
+    frame.color.blue.fill(gamma16(rgb.blue));
+    frame.alpha.fill(alpha);
+}
+
+// Paints every tube's LEDs in its backlight colour at hue_of(tube), then
+// converts all groups in one batch
+template <typename HueOf>
+void draw_groups(LedLayerFrame &frame, HsvFrame<kBacklightLedCount> &hsv, const TubeBacklight &tubes,
+                 HueOf hue_of)
+{
+    for (size_t tube = 0; tube < tubes.size(); ++tube) {
+        const size_t first = tube * kBacklightLedsPerTube;
+        std::fill_n(hsv.hue.begin() + first, kBacklightLedsPerTube, hue_of(tube));
+        std::fill_n(hsv.saturation.begin() + first, kBacklightLedsPerTube, tubes[tube].color.saturation);
+        std::fill_n(hsv.value.begin() + first, kBacklightLedsPerTube, scaled_value(tubes[tube]));
+    }
+    hsv_to_rgb_gamma16(hsv.planes(), frame.color.planes());
+    frame.alpha.fill(255);
+}
+} // namespace
+
+// --- SolidColorEffect ---
+const char *SolidColorEffect::name() const
+{
+    return "solid";
+}
+
+void SolidColorEffect::set_colors(const TubeBacklight &tubes)
+{
+    tubes_ = tubes;
+    changed_ = true;
+}
+
+bool SolidColorEffect::advance(uint32_t dt_ms)
+{
+    (void)dt_ms;
+    const bool changed = changed_;
+    changed_ = false;
+    return changed;
+}
+
+void SolidColorEffect::draw(LedLayerFrame &frame)
+{
+    draw_groups(frame, hsv_, tubes_, [this](size_t tube) { return tubes_[tube].color.hue; });
+}
+
+// --- RainbowEffect ---
+const char *RainbowEffect::name() const
+{
+    return "rainbow";
+}
+
+void RainbowEffect::set_colors(const TubeBacklight &tubes)
+{
+    tubes_ = tubes;
+    changed_ = true;
+}
+
+void RainbowEffect::set_speed(uint16_t degrees_per_s)
+{
+    speed_ = degrees_per_s;
+}
+
+void RainbowEffect::set_spread(uint16_t degrees_per_tube)
+{
+    spread_ = degrees_per_tube % 360;
+    changed_ = true;
+}
+
+void RainbowEffect::restart()
+{
+    phase_mdeg_ = 0;
+    drawn_hue_ = UINT16_MAX;
+}
+
+bool RainbowEffect::advance(uint32_t dt_ms)
+{
+    phase_mdeg_ = (phase_mdeg_ + static_cast<uint32_t>(speed_) * dt_ms) % 360000;
+    const bool changed = changed_ || phase_mdeg_ / 1000 != drawn_hue_;
+    changed_ = false;
+    return changed;
+}
+
+void RainbowEffect::draw(LedLayerFrame &frame)
+{
+    drawn_hue_ = static_cast<uint16_t>(phase_mdeg_ / 1000);
+    draw_groups(frame, hsv_, tubes_, [this](size_t tube) {
+        return static_cast<uint16_t>((drawn_hue_ + tube * spread_) % 360);
+    });
+}
+
+// --- BreathEffect ---
+const char *BreathEffect::name() const
+{
+    return "breath";
+}
+
+void BreathEffect::set_rate(float hz)
+{
+    rate_hz_ = hz;
+}
+
+void BreathEffect::set_phase_step(uint16_t degrees_per_tube)
+{
+    phase_step_ = static_cast<float>(degrees_per_tube % 360) * kTwoPi / 360.0f;
+}
+
+void BreathEffect::restart()
+{
+    phase_ = 0.0f;
+    drawn_ = false;
+}
+
+bool BreathEffect::advance(uint32_t dt_ms)
+{
+    phase_ += rate_hz_ * static_cast<float>(dt_ms) * kTwoPi / 1000.0f;
+    if (phase_ > kTwoPi) {
+        phase_ = std::fmod(phase_, kTwoPi);
+    }
+    for (size_t tube = 0; tube < levels_.size(); ++tube) {
+        const float normalized = (std::sin(phase_ - phase_step_ * tube) + 1.0f) * 0.5f;
+        levels_[tube] = static_cast<uint8_t>(std::round(normalized * 255.0f));
+    }
+    return !drawn_ || levels_ != drawn_levels_;
+}
+
+void BreathEffect::draw(LedLayerFrame &frame)
+{
+    // Gamma-corrected like the layers it scales; at 8.8 the bottom of the
+    // cycle still has distinct steps for the dither to show
+    for (size_t tube = 0; tube < levels_.size(); ++tube) {
+        const size_t first = tube * kBacklightLedsPerTube;
+        const uint16_t level = gamma16(levels_[tube]);
+        std::fill_n(frame.color.red.begin() + first, kBacklightLedsPerTube, level);
+        std::fill_n(frame.color.green.begin() + first, kBacklightLedsPerTube, level);
+        std::fill_n(frame.color.blue.begin() + first, kBacklightLedsPerTube, level);
+    }
+    frame.alpha.fill(255);
+    drawn_levels_ = levels_;
+    drawn_ = true;
+}
+
+// --- FlashEffect ---
+const char *FlashEffect::name() const
+{
+    return "flash";
+}
+
+void FlashEffect::trigger(const RgbColor &color, uint8_t count)
+{
+    color_ = color;
+    duration_ms_ = count * kFlashPeriodMs;
+    elapsed_ms_ = 0;
+    drawn_level_ = -1;
+}
+
+bool FlashEffect::advance(uint32_t dt_ms)
+{
+    if (elapsed_ms_ >= duration_ms_) {
+        level_ = 0;
+    } else {
+        elapsed_ms_ += dt_ms;
+        // Triangle up and down once per period
+        const uint32_t t = elapsed_ms_ % kFlashPeriodMs;
+        const uint32_t half = kFlashPeriodMs / 2;
+        const uint32_t ramp = t < half ? t : kFlashPeriodMs - t;
+        level_ = elapsed_ms_ >= duration_ms_ ? 0 : static_cast<uint8_t>(ramp * 255 / half);
+    }
+    return level_ != drawn_level_;
+}
+
+void FlashEffect::draw(LedLayerFrame &frame)
+{
+    fill_solid(frame, color_, level_);
+    drawn_level_ = level_;
+}
+
+// --- BatteryBarEffect ---
+const char *BatteryBarEffect::name() const
+{
+    return "battery";
+}
+
+void BatteryBarEffect::set_level(uint8_t soc_percent)
+{
+    soc_percent = std::min<uint8_t>(soc_percent, 100);
+    if (has_level_ && soc_percent == soc_) {
+        return;
+    }
+    soc_ = soc_percent;
+    has_level_ = true;
+    shown_ms_ = 0;
+    changed_ = true;
+}
+
+bool BatteryBarEffect::advance(uint32_t dt_ms)
+{
+    if (shown_ms_ >= kBatteryShowMs + kBatteryFadeMs) {
+        const bool changed = changed_ || visibility_ != 0;
+        visibility_ = 0;
+        changed_ = false;
+        return changed;
+    }
+    shown_ms_ += dt_ms;
+    uint8_t visibility = 255;
+    if (shown_ms_ >= kBatteryShowMs + kBatteryFadeMs) {
+        visibility = 0;
+    } else if (shown_ms_ > kBatteryShowMs) {
+        visibility = static_cast<uint8_t>(255 - (shown_ms_ - kBatteryShowMs) * 255 / kBatteryFadeMs);
+    }
+    const bool changed = changed_ || visibility != visibility_;
+    visibility_ = visibility;
+    changed_ = false;
+    return changed;
+}
+
+void BatteryBarEffect::draw(LedLayerFrame &frame)
+{
+    // Fill level in 1/255ths of an LED, so the last lit LED shows the
+    // remainder as partial coverage
+    constexpr size_t kCount = kBacklightLedCount;
+    const uint32_t fill = static_cast<uint32_t>(soc_) * kCount * 255 / 100;
+    for (size_t i = 0; i < kCount; ++i) {
+        hsv_.hue[i] = static_cast<uint16_t>(kCount > 1 ? i * kBatteryFullHue / (kCount - 1) : kBatteryFullHue);
+        hsv_.saturation[i] = 255;
+        hsv_.value[i] = 255;
+        const uint32_t lit = i * 255 >= fill ? 0 : std::min<uint32_t>(fill - i * 255, 255);
+        frame.alpha[i] = static_cast<uint8_t>(lit * visibility_ / 255);
+    }
+    hsv_to_rgb_gamma16(hsv_.planes(), frame.color.planes());
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "led_compositor.h"
+#include "led_driver.h"
+
+// One backlight colour and brightness per tube, i.e. per LED group
+using TubeBacklight = std::array<BackLightState, kNixieTubeCount>;
+
+// Each tube's backlight colour at its brightness. Redraws only when set.
+class SolidColorEffect : public ILedEffect
+{
+public:
+    const char *name() const override;
+    void set_colors(const TubeBacklight &tubes);
+    bool advance(uint32_t dt_ms) override;
+    void draw(LedLayerFrame &frame) override;
+
+private:
+    TubeBacklight tubes_{};
+    bool changed_ = true;
+    HsvFrame<kBacklightLedCount> hsv_;
+};
+
+// Each tube's saturation and brightness with the hue turning at a fixed
+// rate. A spread offsets every tube's hue from the one before it, so the
+// colours chase across the display.
+class RainbowEffect : public ILedEffect
+{
+public:
+    const char *name() const override;
+    void set_colors(const TubeBacklight &tubes);
+    void set_speed(uint16_t degrees_per_s);
+    void set_spread(uint16_t degrees_per_tube);
+    bool advance(uint32_t dt_ms) override;
+    void draw(LedLayerFrame &frame) override;
+    void restart() override;
+
+private:
+    TubeBacklight tubes_{};
+    uint16_t speed_ = 60;
+    uint16_t spread_ = 0;
+    uint32_t phase_mdeg_ = 0;
+    uint16_t drawn_hue_ = UINT16_MAX;
+    bool changed_ = true;
+    HsvFrame<kBacklightLedCount> hsv_;
+};
+
+// Sine brightness envelope; a MULTIPLY layer, so it breathes whatever is
+// beneath it. A phase step lags each tube behind the one before it, for a
+// wave across the display.
+class BreathEffect : public ILedEffect
+{
+public:
+    const char *name() const override;
+    void set_rate(float hz);
+    void set_phase_step(uint16_t degrees_per_tube);
+    bool advance(uint32_t dt_ms) override;
+    void draw(LedLayerFrame &frame) override;
+    void restart() override;
+
+private:
+    float rate_hz_ = 0.35f;
+    float phase_step_ = 0.0f;
+    float phase_ = 0.0f;
+    std::array<uint8_t, kNixieTubeCount> levels_{};
+    bool drawn_ = false;
+    std::array<uint8_t, kNixieTubeCount> drawn_levels_{};
+};
+
+// Short overlay flashes, e.g. for an alarm. Transparent when idle.
+class FlashEffect : public ILedEffect
+{
+public:
+    const char *name() const override;
+    void trigger(const RgbColor &color, uint8_t count);
+    bool advance(uint32_t dt_ms) override;
+    void draw(LedLayerFrame &frame) override;
+
+private:
+    RgbColor color_{};
+    uint32_t duration_ms_ = 0;
+    uint32_t elapsed_ms_ = 0;
+    uint8_t level_ = 0;
+    int drawn_level_ = -1;
+};
+
+// State-of-charge bar from the first LED, red to green, shown for a few
+// seconds whenever the level changes. Transparent the rest of the time.
+class BatteryBarEffect : public ILedEffect
+{
+public:
+    const char *name() const override;
+    void set_level(uint8_t soc_percent);
+    bool advance(uint32_t dt_ms) override;
+    void draw(LedLayerFrame &frame) override;
+
+private:
+    uint8_t soc_ = 0;
+    bool has_level_ = false;
+    uint32_t shown_ms_ = UINT32_MAX;
+    uint8_t visibility_ = 0;
+    bool changed_ = false;
+    HsvFrame<kBacklightLedCount> hsv_;
+};
@@ -4,9 +4,11 @@
 #include "driver/gpio.h"
 
 #include "nixie_driver.h"
+#include "hv57708_nixie_driver.h"
 #include "led_driver.h"
 #include "audio_driver.h"
 #include "daemons/display_daemon.h"
+#include "cathode_care.h"
 #include "daemons/audio_daemon.h"
 #include "daemons/gasgauge_daemon.h"
 #include "daemons/power_daemon.h"
@@ -45,7 +47,14 @@ extern "C" void app_main(void)
     
     // Initialize Nixie Driver
     // Now NixieDriver manages its own tubes internally.
+#ifdef CONFIG_NIXIE_BACKEND_HV57708
+    static Hv57708NixieDriver nixie_driver;
+#else
     static NixieDriver nixie_driver;
+#endif
+    static SettingsStore settings_store;
+    static CathodeCare cathode_care(nixie_driver, settings_store);
+    cathode_care.restore();
     nixie_driver.nixie_scan_start(hw_handles.i2c_port);
     
     // Initialize Audio Driver
@@ -58,7 +67,7 @@ extern "C" void app_main(void)
     static Ina3221 power_monitor_driver(hw_handles.i2c_port);
 
     // 2. Initialize Daemons
-    static DisplayDaemon display_daemon(nixie_driver, led_driver);
+    static DisplayDaemon display_daemon(nixie_driver, led_driver, cathode_care);
     static AudioDaemon audio_daemon(audio_driver);
 
     // 3. Initialize System Controller
@@ -71,17 +80,20 @@ extern "C" void app_main(void)
     static PowerDaemon power_daemon(power_monitor_driver, system_controller.get_queue());
 
     // 3.1 Load persisted settings and apply
-    static SettingsStore settings_store;
     ClockSettings settings;
     if (settings_store.load(&settings)) {
         system_controller.apply_settings(settings, nullptr);
     }
+    NixieCalibration calibration;
+    if (settings_store.load_calibration(&calibration)) {
+        nixie_driver.set_calibration(calibration);
+    }
 
     // 4. Initialize CLI Daemon
-    static CliDaemon cli_daemon(system_controller);
+    static CliDaemon cli_daemon(system_controller, nixie_driver, settings_store, display_daemon, led_driver);
 
     // 4.1 Initialize Web Server
-    static WebServer web_server(system_controller, settings_store);
+    static WebServer web_server(system_controller, settings_store, nixie_driver);
 
     // 5. Start Tasks
     ESP_LOGI(kLogTag, "Starting Daemons...");
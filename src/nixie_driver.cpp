@@ -1,120 +1,352 @@
 #include "nixie_driver.h"
+#include "heap_monitor.h"
 #include "pca9685/pca9685.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
+#include "driver/ledc.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <algorithm>
+#include <utility>
 
 namespace
 {
 constexpr gpio_num_t kPca9685OePin = static_cast<gpio_num_t>(4);
 
-constexpr float kPwmFrequencyHz = 200.0f;
+#ifdef CONFIG_NIXIE_OE_PWM_DIMMING
+// OE is active low, so the channel output is inverted and the LEDC duty is
+// the share of time the PCA9685 outputs are enabled.
+constexpr ledc_timer_t kOeLedcTimer = LEDC_TIMER_0;
+constexpr ledc_channel_t kOeLedcChannel = LEDC_CHANNEL_0;
+constexpr ledc_timer_bit_t kOeLedcResolution = LEDC_TIMER_10_BIT;
+constexpr uint32_t kOeLedcFullDuty = 1u << 10;
+#endif
 constexpr uint32_t kScanFrameHz = 100;
-constexpr uint32_t kFramePeriodMs = 1000 / kScanFrameHz;
-constexpr uint32_t kStepMs = 1;
-constexpr uint32_t kExtraIdleMs = (kFramePeriodMs > (kStepMs * 6))
-                                     ? (kFramePeriodMs - (kStepMs * 6))
-                                     : 0;
 
-constexpr uint8_t kPcaAddresses[4] = {0x40, 0x41, 0x42, 0x43};
+// Sequential mode: a 1 MHz gptimer cuts each frame into fixed slots. The
+// first six light one tube each, the rest keep every tube blank.
+// A slot lasts exactly one PCA9685 PWM period, so whatever its phase against
+// the chips' oscillator a tube sees every count of the period once and a
+// duty below full dims it linearly. The slot follows the period the
+// prescaler really gives, not the nominal 1 kHz.
+constexpr uint32_t kSlotTimerHz = 1000000;
+constexpr uint8_t kPwmPrescale = Pca9685::prescale_for(1000.0f);
+constexpr uint32_t kSlotUs = Pca9685::period_us(kPwmPrescale);
+constexpr float kPwmFrequencyHz = Pca9685::kOscillatorHz / (4096.0f * (kPwmPrescale + 1));
+constexpr uint32_t kSlotsPerFrame = kSlotTimerHz / (kScanFrameHz * kSlotUs);
+constexpr uint32_t kFramePeriodUs = kSlotsPerFrame * kSlotUs;
+constexpr uint32_t kRampOne = 4096;
+constexpr uint32_t kWearPublishMs = 1000;
+constexpr TickType_t kStaggeredWearTicks = pdMS_TO_TICKS(kWearPublishMs);
+static_assert(kSlotsPerFrame >= kNixieTubeCount, "Every tube needs its own slot");
+// Upper bound on a single wait so a stalled timer is noticed and logged
+constexpr TickType_t kSlotWaitTicks = pdMS_TO_TICKS(100);
 
-struct ChannelRef
+// Staggered mode: tube k of n owns [k * 4096 / n, (k + 1) * 4096 / n) of
+// the PWM period. The chips run from their own oscillators, so windows on
+// different chips drift against each other; every counter is restarted
+// together each resync interval, and a dark guard band as wide as the drift
+// in between keeps two tubes from ever lighting together.
+constexpr uint16_t kPwmPeriodTicks = 4096;
+#ifdef CONFIG_NIXIE_STAGGERED_RESYNC_MS
+constexpr uint32_t kStaggeredResyncMs = CONFIG_NIXIE_STAGGERED_RESYNC_MS;
+constexpr uint32_t kOscMismatchPpm = CONFIG_NIXIE_PCA_OSC_MISMATCH_PPM;
+#else
+constexpr uint32_t kStaggeredResyncMs = 40;
+constexpr uint32_t kOscMismatchPpm = 1000;
+#endif
+constexpr uint32_t kStaggeredDriftUs = (kOscMismatchPpm * kStaggeredResyncMs + 999) / 1000;
+constexpr uint16_t kStaggeredWindowTicks = static_cast<uint16_t>(kPwmPeriodTicks / kNixieTubeCount);
+constexpr uint16_t kStaggeredGuardTicks =
+    static_cast<uint16_t>((kStaggeredDriftUs * kPwmPeriodTicks + kSlotUs - 1) / kSlotUs);
+static_assert(kStaggeredGuardTicks < kStaggeredWindowTicks,
+              "Oscillator drift over the resync interval leaves no staggered window");
+constexpr TickType_t kStaggeredResyncTicks =
+    kStaggeredResyncMs / portTICK_PERIOD_MS > 0 ? kStaggeredResyncMs / portTICK_PERIOD_MS : 1;
+// SLEEP takes hold at the end of a chip's period, which may run long by the
+// oscillator tolerance
+constexpr uint32_t kSleepWaitUs = kSlotUs + kSlotUs / 10;
+
+template <size_t... Index>
+std::array<Pca9685, sizeof...(Index)> make_board_chips(i2c_port_t port, std::index_sequence<Index...>)
 {
-    uint8_t chip_index;
-    uint8_t channel;
-};
+    return {Pca9685(port, kBoard.pca_addresses[Index], I2cPriority::REALTIME)...};
+}
 
-std::array<std::array<ChannelRef, 10>, 6> kTubeMap = {};
-bool kMapInitialized = false;
+} // namespace
+
+static const char *kTag = "NixieDriver";
 
-void init_default_mapping()
+NixieDriver::NixieDriver()
+    : pending_{{}, 128, NixieTransition::NONE, 0},
+      frames_(pending_),
+      scan_frame_(pending_),
+      calibration_pending_(uniform_nixie_calibration()),
+      calibration_(calibration_pending_),
+#ifdef CONFIG_NIXIE_SCAN_STAGGERED
+      scan_mode_(NixieScanMode::STAGGERED)
+#else
+      scan_mode_(NixieScanMode::SEQUENTIAL)
+#endif
 {
-    if (kMapInitialized) {
-        return;
+    // tubes_ is initialized by default constructor
+    rebuild_duty_table();
+}
+
+void NixieDriver::display_time(uint8_t h, uint8_t m, uint8_t s)
+{
+    pending_.digits[0] = h / 10;
+    pending_.digits[1] = h % 10;
+    pending_.digits[2] = m / 10;
+    pending_.digits[3] = m % 10;
+    pending_.digits[4] = s / 10;
+    pending_.digits[5] = s % 10;
+    publish_digits();
+}
+
+void NixieDriver::display_number(uint32_t number)
+{
+    for (int i = static_cast<int>(pending_.digits.size()) - 1; i >= 0; --i) {
+        pending_.digits[static_cast<size_t>(i)] = number % 10;
+        number /= 10;
     }
-    // Tube 1: 0x40 ch0-9
-    for (uint8_t d = 0; d < 10; ++d) {
-        kTubeMap[0][d] = {0, d};
+    publish_digits();
+}
+
+void NixieDriver::set_brightness(uint8_t brightness)
+{
+    pending_.brightness = brightness;
+    frames_.publish(pending_);
+    if (oe_dimming_) {
+        apply_oe_brightness(brightness);
+    } else {
+        request_refresh();
     }
-    // Tube 2: 0x40 ch10-15 + 0x41 ch0-3
-    for (uint8_t d = 0; d < 6; ++d) {
-        kTubeMap[1][d] = {0, static_cast<uint8_t>(10 + d)};
+}
+
+void NixieDriver::set_digits(const NixieDigits &digits)
+{
+    pending_.digits = digits;
+    publish_digits();
+}
+
+void NixieDriver::publish_digits()
+{
+    for (size_t i = 0; i < tubes_.size(); ++i) {
+        tubes_[i].set_numeral(pending_.digits[i]);
     }
-    for (uint8_t d = 6; d < 10; ++d) {
-        kTubeMap[1][d] = {1, static_cast<uint8_t>(d - 6)};
+    frames_.publish(pending_);
+    request_refresh();
+}
+
+void NixieDriver::set_transition(NixieTransition transition, uint16_t duration_ms)
+{
+    pending_.transition = transition;
+    pending_.transition_ms = duration_ms;
+    frames_.publish(pending_);
+}
+
+bool NixieDriver::latch_frame()
+{
+    const bool frame_changed = frames_.sequence() != scan_frame_sequence_;
+    const bool calibration_changed = calibration_.sequence() != calibration_sequence_;
+    if (!frame_changed && !calibration_changed) {
+        return false;
     }
-    // Tube 3: 0x41 ch4-13
-    for (uint8_t d = 0; d < 10; ++d) {
-        kTubeMap[2][d] = {1, static_cast<uint8_t>(4 + d)};
+    const uint8_t old_brightness = scan_frame_.brightness;
+    if (frame_changed) {
+        const NixieDigits old_digits = scan_frame_.digits;
+        scan_frame_sequence_ = frames_.read(scan_frame_);
+        // Staggered mode programs the chips once per change, so it cannot
+        // animate and switches instantly
+        if (old_digits != scan_frame_.digits && scan_mode_ == NixieScanMode::SEQUENTIAL) {
+            start_transition(old_digits);
+        }
     }
-    // Tube 4: 0x42 ch0-9
-    for (uint8_t d = 0; d < 10; ++d) {
-        kTubeMap[3][d] = {2, d};
+    if (calibration_changed || scan_frame_.brightness != old_brightness) {
+        rebuild_duty_table();
     }
-    // Tube 5: 0x42 ch10-15 + 0x43 ch0-3
-    for (uint8_t d = 0; d < 6; ++d) {
-        kTubeMap[4][d] = {2, static_cast<uint8_t>(10 + d)};
+    return true;
+}
+
+void NixieDriver::rebuild_duty_table()
+{
+    NixieCalibration calibration;
+    calibration_sequence_ = calibration_.read(calibration);
+    const uint8_t level = pca_brightness();
+    for (size_t tube = 0; tube < duty_table_.size(); ++tube) {
+        for (size_t numeral = 0; numeral < duty_table_[tube].size(); ++numeral) {
+            duty_table_[tube][numeral] = nixie_cathode_duty(level, calibration[tube][numeral]);
+        }
     }
-    for (uint8_t d = 6; d < 10; ++d) {
-        kTubeMap[4][d] = {3, static_cast<uint8_t>(d - 6)};
+}
+
+void NixieDriver::start_transition(const NixieDigits &from)
+{
+    const uint32_t frames = std::min<uint32_t>((scan_frame_.transition_ms * 1000u) / kFramePeriodUs, kMaxTransitionFrames);
+    if (scan_frame_.transition == NixieTransition::NONE || frames < 2) {
+        active_transition_ = NixieTransition::NONE;
+        return;
     }
-    // Tube 6: 0x43 ch4-13
-    for (uint8_t d = 0; d < 10; ++d) {
-        kTubeMap[5][d] = {3, static_cast<uint8_t>(4 + d)};
+    if (scan_frame_.transition_ms != ramp_duration_ms_ || frames != transition_frames_) {
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            const uint64_t x = ((frame + 1) * kRampOne) / frames;
+            ramp_[frame] = static_cast<uint16_t>((x * x * (3 * kRampOne - 2 * x)) / (kRampOne * kRampOne));
+        }
+        ramp_duration_ms_ = scan_frame_.transition_ms;
+        transition_frames_ = static_cast<uint16_t>(frames);
     }
 
-    kMapInitialized = true;
+    transition_mask_ = 0;
+    for (size_t tube = 0; tube < from.size(); ++tube) {
+        if (from[tube] != scan_frame_.digits[tube]) {
+            transition_mask_ |= static_cast<uint8_t>(1u << tube);
+        }
+    }
+    transition_from_ = from;
+    transition_step_ = 0;
+    active_transition_ = scan_frame_.transition;
 }
 
-} // namespace
+void NixieDriver::plan_frame()
+{
+    const uint32_t progress = (active_transition_ != NixieTransition::NONE) ? ramp_[transition_step_] : kRampOne;
 
-static const char *kTag = "NixieDriver";
+    for (size_t tube = 0; tube < plans_.size(); ++tube) {
+        TubePlan &plan = plans_[tube];
+        const uint8_t to = scan_frame_.digits[tube] % 10;
+        const uint8_t from = transition_from_[tube] % 10;
+        const bool changed = transition_mask_ & (1u << tube);
+        plan = {to, duty_table_[tube][to], kNoNumeral, 0, 0};
 
-NixieDriver::NixieDriver()
-    : brightness_(128)
-{
-    // tubes_ is initialized by default constructor
-    for (size_t i = 0; i < digit_cache_.size(); ++i) {
-        digit_cache_[i] = 0;
+        switch (active_transition_) {
+            case NixieTransition::CROSSFADE:
+                if (changed) {
+                    // Back to back inside the PWM period, never overlapping.
+                    // The slot is exactly one period, so the tube sees both
+                    // pulses whole whatever the chips' phase; the mix only
+                    // moves from frame to frame as the ramp advances.
+                    const uint16_t old_off = static_cast<uint16_t>((duty_table_[tube][from] * (kRampOne - progress)) >> 12);
+                    const uint16_t new_width = static_cast<uint16_t>((duty_table_[tube][to] * progress) >> 12);
+                    plan = {from, old_off, to, old_off,
+                            static_cast<uint16_t>(std::min<uint32_t>(old_off + new_width, 4095))};
+                }
+                break;
+            case NixieTransition::SLOT_ROLL:
+                if (changed) {
+                    const uint32_t distance = (to + 10 - from) % 10;
+                    const uint8_t numeral = static_cast<uint8_t>((from + ((distance * progress) >> 12)) % 10);
+                    plan.numeral = numeral;
+                    plan.off = duty_table_[tube][numeral];
+                }
+                break;
+            case NixieTransition::SCROLL: {
+                // Old reading, one blank tube, new reading, sliding left by
+                // one more place than there are tubes
+                const size_t tubes = plans_.size();
+                const size_t position = tube + (((tubes + 1) * progress) >> 12);
+                if (position < tubes) {
+                    const uint8_t numeral = transition_from_[position] % 10;
+                    plan.numeral = numeral;
+                    plan.off = duty_table_[tube][numeral];
+                } else if (position == tubes) {
+                    plan.numeral = kNoNumeral;
+                } else {
+                    const uint8_t numeral = scan_frame_.digits[position - (tubes + 1)] % 10;
+                    plan.numeral = numeral;
+                    plan.off = duty_table_[tube][numeral];
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (active_transition_ != NixieTransition::NONE && ++transition_step_ >= transition_frames_) {
+        active_transition_ = NixieTransition::NONE;
     }
 }
 
-void NixieDriver::display_time(uint8_t h, uint8_t m, uint8_t s)
+void NixieDriver::set_calibration(const NixieCalibration &calibration)
 {
-    if (tubes_.size() >= 6) {
-        digit_cache_[0] = h / 10;
-        digit_cache_[1] = h % 10;
-        digit_cache_[2] = m / 10;
-        digit_cache_[3] = m % 10;
-        digit_cache_[4] = s / 10;
-        digit_cache_[5] = s % 10;
-        for (size_t i = 0; i < tubes_.size(); ++i) {
-            tubes_[i].set_numeral(digit_cache_[i]);
-        }
+    taskENTER_CRITICAL(&calibration_lock_);
+    calibration_pending_ = calibration;
+    calibration_.publish(calibration_pending_);
+    taskEXIT_CRITICAL(&calibration_lock_);
+    request_refresh();
+}
+
+NixieCalibration NixieDriver::get_calibration() const
+{
+    taskENTER_CRITICAL(&calibration_lock_);
+    NixieCalibration copy = calibration_pending_;
+    taskEXIT_CRITICAL(&calibration_lock_);
+    return copy;
+}
+
+NixieWear NixieDriver::get_wear() const
+{
+    NixieWear wear;
+    wear_.read(wear);
+    return wear;
+}
+
+bool NixieDriver::restore_wear(const NixieWear &wear)
+{
+    // The counter belongs to the scan task once it runs
+    if (scan_task_) {
+        return false;
     }
+    wear_counter_.restore(wear);
+    wear_.publish(wear);
+    return true;
 }
 
-void NixieDriver::display_number(uint32_t number)
+void NixieDriver::account_wear()
 {
-    for (int i = static_cast<int>(tubes_.size()) - 1; i >= 0; --i) {
-        digit_cache_[static_cast<size_t>(i)] = number % 10;
-        tubes_[static_cast<size_t>(i)].set_numeral(digit_cache_[static_cast<size_t>(i)]);
-        number /= 10;
+    const int64_t now_us = esp_timer_get_time();
+    const uint32_t elapsed_ms = static_cast<uint32_t>((now_us - wear_last_us_) / 1000);
+    if (elapsed_ms == 0) {
+        return;
+    }
+    wear_last_us_ += static_cast<int64_t>(elapsed_ms) * 1000;
+
+    // Whatever the plans lit since the last call, both cathodes of a crossfade
+    if (scan_frame_.brightness > 0) {
+        for (size_t tube = 0; tube < plans_.size(); ++tube) {
+            const TubePlan &plan = plans_[tube];
+            if (plan.numeral < 10 && plan.off > 0) {
+                wear_counter_.add(tube, plan.numeral, elapsed_ms);
+            }
+            if (plan.fade_numeral < 10 && plan.fade_off > plan.fade_on) {
+                wear_counter_.add(tube, plan.fade_numeral, elapsed_ms);
+            }
+        }
+    }
+
+    wear_publish_ms_ += elapsed_ms;
+    if (wear_publish_ms_ >= kWearPublishMs) {
+        wear_publish_ms_ = 0;
+        wear_.publish(wear_counter_.seconds());
     }
 }
 
-void NixieDriver::set_brightness(uint8_t brightness)
+void NixieDriver::set_scan_mode(NixieScanMode mode)
 {
-    brightness_ = brightness;
+    scan_mode_ = mode;
+    if (scan_task_) {
+        xTaskNotifyGive(scan_task_);
+    }
 }
 
-void NixieDriver::set_digits(const std::array<uint8_t, 6> &digits)
+void NixieDriver::request_refresh()
 {
-    digit_cache_ = digits;
-    for (size_t i = 0; i < tubes_.size(); ++i) {
-        tubes_[i].set_numeral(digit_cache_[i]);
+    // Only the staggered mode sleeps between changes; the sequential scan
+    // picks new digits up on its next step anyway.
+    if (scan_task_ && scan_mode_ == NixieScanMode::STAGGERED) {
+        xTaskNotifyGive(scan_task_);
     }
 }
 
@@ -124,10 +356,22 @@ void NixieDriver::nixie_scan_start(i2c_port_t i2c_port)
         return;
     }
     i2c_port_ = i2c_port;
-    init_default_mapping();
     xTaskCreate(scan_task_entry, "nixie_scan", 4096, this, 6, &scan_task_);
 }
 
+NixieScanStats NixieDriver::get_scan_stats() const
+{
+    NixieScanStats stats;
+    scan_stats_published_.read(stats);
+    return stats;
+}
+
+void NixieDriver::reset_scan_stats()
+{
+    // Cleared by the scan task itself so it never races a half-written sample
+    stats_reset_requested_ = true;
+}
+
 std::vector<NixieTube *> NixieDriver::get_tubes()
 {
     std::vector<NixieTube *> ptrs;
@@ -144,16 +388,51 @@ void NixieDriver::scan_task_entry(void *param)
     driver->scan_loop();
 }
 
+bool IRAM_ATTR NixieDriver::on_slot_alarm(gptimer_handle_t timer,
+                                          const gptimer_alarm_event_data_t *event,
+                                          void *user_ctx)
+{
+    auto *driver = static_cast<NixieDriver *>(user_ctx);
+    driver->slot_start_us_.store(static_cast<uint32_t>(esp_timer_get_time()), std::memory_order_relaxed);
+    driver->slot_sequence_.fetch_add(1, std::memory_order_release);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(driver->scan_task_, &woken);
+    return woken == pdTRUE;
+}
+
+bool NixieDriver::create_slot_timer()
+{
+    gptimer_config_t timer_config = {};
+    timer_config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    timer_config.direction = GPTIMER_COUNT_UP;
+    timer_config.resolution_hz = kSlotTimerHz;
+    if (gptimer_new_timer(&timer_config, &slot_timer_) != ESP_OK) {
+        return false;
+    }
+
+    gptimer_alarm_config_t alarm_config = {};
+    alarm_config.alarm_count = kSlotUs;
+    alarm_config.reload_count = 0;
+    alarm_config.flags.auto_reload_on_alarm = true;
+    if (gptimer_set_alarm_action(slot_timer_, &alarm_config) != ESP_OK) {
+        return false;
+    }
+
+    gptimer_event_callbacks_t callbacks = {};
+    callbacks.on_alarm = on_slot_alarm;
+    if (gptimer_register_event_callbacks(slot_timer_, &callbacks, this) != ESP_OK) {
+        return false;
+    }
+    return gptimer_enable(slot_timer_) == ESP_OK;
+}
+
 void NixieDriver::scan_loop()
 {
     // I2C is initialized by SystemController
     
-    std::array<Pca9685, 4> pca = {
-        Pca9685(i2c_port_, kPcaAddresses[0]),
-        Pca9685(i2c_port_, kPcaAddresses[1]),
-        Pca9685(i2c_port_, kPcaAddresses[2]),
-        Pca9685(i2c_port_, kPcaAddresses[3])
-    };
+    std::array<Pca9685, kNixiePcaCount> pca = make_board_chips(i2c_port_, std::make_index_sequence<kNixiePcaCount>());
+    Pca9685Group all_chips(i2c_port_, Pca9685::kAllCallAddress, I2cPriority::REALTIME);
 
     for (auto &chip : pca) {
         if (!chip.init(kPwmFrequencyHz)) {
@@ -164,35 +443,250 @@ void NixieDriver::scan_loop()
         chip.set_all_off();
     }
 
-    // Enable PCA9685 outputs
-    gpio_set_level(kPca9685OePin, 0);
+    if (!create_slot_timer()) {
+        ESP_LOGE(kTag, "Failed to create scan slot timer");
+        vTaskDelete(nullptr);
+        return;
+    }
+
+    // Enable PCA9685 outputs, as a static enable if OE dimming is off
+    latch_frame();
+    plan_frame();
+    wear_last_us_ = esp_timer_get_time();
+    if (!init_oe_dimming()) {
+        gpio_set_level(kPca9685OePin, 0);
+    }
+
+    frame_start_bytes_ = all_chips.bytes_written();
+    for (const auto &chip : pca) {
+        frame_start_bytes_ += chip.bytes_written();
+    }
+    heap_slot_ = HeapMonitor::watch_current_task();
+    frame_start_allocations_ = HeapMonitor::allocation_count(heap_slot_);
 
-    size_t tube_index = 0;
+    bool timer_running = false;
+    bool staggered_programmed = false;
+    bool blanked = false;
+    uint32_t handled_sequence = 0;
     while (true) {
-        const uint8_t numeral = digit_cache_[tube_index] % 10;
-        const uint16_t duty = static_cast<uint16_t>((static_cast<uint32_t>(brightness_) * 4095) / 255);
+        if (stats_reset_requested_.exchange(false)) {
+            scan_stats_ = {};
+            scan_stats_published_.publish(scan_stats_);
+        }
+
+        if (scan_mode_ == NixieScanMode::STAGGERED) {
+            if (timer_running) {
+                gptimer_stop(slot_timer_);
+                timer_running = false;
+            }
+            // The chips run the multiplexing on their own; the bus is only
+            // touched again when a digit, the brightness or the mode changes,
+            // and to pull the counters back in step before the drift eats
+            // the guard band. The timeout also keeps the wear counters ticking.
+            account_wear();
+            bool touched = false;
+            if (latch_frame() || !staggered_programmed) {
+                plan_frame();
+                program_staggered_frame(pca);
+                staggered_programmed = true;
+                touched = true;
+            }
+            const int64_t now_us = esp_timer_get_time();
+            if (now_us - staggered_resync_us_ >= static_cast<int64_t>(kStaggeredResyncMs) * 1000) {
+                all_chips.restart_counters(kSleepWaitUs);
+                staggered_resync_us_ = now_us;
+                touched = true;
+            }
+            if (touched) {
+                record_frame_bytes(pca, all_chips);
+            }
+            blanked = false;
+            ulTaskNotifyTake(pdTRUE, std::min(kStaggeredWearTicks, kStaggeredResyncTicks));
+            continue;
+        }
+        staggered_programmed = false;
+
+        if (!timer_running) {
+            handled_sequence = slot_sequence_.load(std::memory_order_acquire);
+            gptimer_start(slot_timer_);
+            timer_running = true;
+        }
 
-        for (auto &chip : pca) {
-            chip.set_all_off();
+        if (ulTaskNotifyTake(pdTRUE, kSlotWaitTicks) == 0) {
+            ESP_LOGW(kTag, "Slot timer stalled");
+            continue;
+        }
+        // Refresh and mode-change notifications share the counter, so only
+        // an advanced sequence marks a slot boundary.
+        const uint32_t sequence = slot_sequence_.load(std::memory_order_acquire);
+        if (sequence == handled_sequence) {
+            continue;
+        }
+        record_slot_timing(slot_start_us_.load(std::memory_order_relaxed),
+                           sequence - handled_sequence - 1);
+        const bool frame_done = (sequence / kSlotsPerFrame) != (handled_sequence / kSlotsPerFrame);
+        handled_sequence = sequence;
+
+        // One transaction per step: an ALLCALL write blanks all four chips,
+        // so two tubes are never lit together, and the lit channel of the
+        // tube that owns this slot follows after a repeated START. Idle
+        // slots after the first have nothing to send.
+        // New digits are only taken at frame boundaries, so a frame never
+        // shows half of the old time and half of the new one.
+        if (frame_done) {
+            account_wear();
+            latch_frame();
+            plan_frame();
+        }
+        const size_t slot = sequence % kSlotsPerFrame;
+        const bool lit = slot < scan_frame_.digits.size();
+        if (lit || !blanked) {
+            for (auto &chip : pca) {
+                chip.stage_all_off();
+            }
+            if (lit) {
+                stage_tube_plan(pca, slot);
+            }
+            all_chips.blank_and_flush(pca.data(), pca.size());
+            blanked = !lit;
         }
-        apply_tube_output(pca, tube_index, numeral, duty);
 
-        tube_index = (tube_index + 1) % tubes_.size();
-        vTaskDelay(pdMS_TO_TICKS(kStepMs));
-        if (tube_index == 0 && kExtraIdleMs > 0) {
-            vTaskDelay(pdMS_TO_TICKS(kExtraIdleMs));
+        if (frame_done) {
+            record_frame_bytes(pca, all_chips);
         }
     }
 }
 
-void NixieDriver::apply_tube_output(std::array<Pca9685, 4> &pca,
-                                    size_t tube_index,
-                                    uint8_t numeral,
-                                    uint16_t duty)
+bool NixieDriver::init_oe_dimming()
 {
-    if (tube_index >= kTubeMap.size() || numeral >= 10) {
+#ifdef CONFIG_NIXIE_OE_PWM_DIMMING
+    ledc_timer_config_t timer_config = {};
+    timer_config.speed_mode = LEDC_LOW_SPEED_MODE;
+    timer_config.duty_resolution = kOeLedcResolution;
+    timer_config.timer_num = kOeLedcTimer;
+    timer_config.freq_hz = CONFIG_NIXIE_OE_PWM_FREQ_HZ;
+    timer_config.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer_config) != ESP_OK) {
+        ESP_LOGW(kTag, "OE dimming timer unavailable, falling back to I2C duty");
+        return false;
+    }
+
+    ledc_channel_config_t channel_config = {};
+    channel_config.gpio_num = kPca9685OePin;
+    channel_config.speed_mode = LEDC_LOW_SPEED_MODE;
+    channel_config.channel = kOeLedcChannel;
+    channel_config.intr_type = LEDC_INTR_DISABLE;
+    channel_config.timer_sel = kOeLedcTimer;
+    channel_config.duty = (static_cast<uint32_t>(scan_frame_.brightness) * kOeLedcFullDuty) / 255;
+    channel_config.hpoint = 0;
+    channel_config.flags.output_invert = 1;
+    if (ledc_channel_config(&channel_config) != ESP_OK) {
+        ESP_LOGW(kTag, "OE dimming channel unavailable, falling back to I2C duty");
+        return false;
+    }
+
+    // Brightness is owned by OE from here on, the PCA duty stays at full.
+    // Re-read in case set_brightness() ran before it saw the flag.
+    oe_dimming_ = true;
+    rebuild_duty_table();
+    NixieFrame latest;
+    frames_.read(latest);
+    apply_oe_brightness(latest.brightness);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void NixieDriver::apply_oe_brightness(uint8_t brightness)
+{
+#ifdef CONFIG_NIXIE_OE_PWM_DIMMING
+    const uint32_t duty = (static_cast<uint32_t>(brightness) * kOeLedcFullDuty) / 255;
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, kOeLedcChannel, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, kOeLedcChannel);
+#endif
+}
+
+uint8_t NixieDriver::pca_brightness() const
+{
+    return oe_dimming_ ? 255 : scan_frame_.brightness;
+}
+
+void NixieDriver::stage_tube_plan(std::array<Pca9685, kNixiePcaCount> &pca, size_t tube_index)
+{
+    if (tube_index >= kBoard.tube_map.size()) {
         return;
     }
-    const ChannelRef ref = kTubeMap[tube_index][numeral];
-    pca[ref.chip_index].set_duty(ref.channel, duty);
+    const TubePlan &plan = plans_[tube_index];
+    if (plan.numeral < 10) {
+        const NixieChannel ref = kBoard.tube_map[tube_index][plan.numeral];
+        pca[ref.chip_index].stage_pwm(ref.channel, 0, plan.off);
+    }
+    if (plan.fade_numeral < 10) {
+        const NixieChannel ref = kBoard.tube_map[tube_index][plan.fade_numeral];
+        pca[ref.chip_index].stage_pwm(ref.channel, plan.fade_on, plan.fade_off);
+    }
+}
+
+void NixieDriver::program_staggered_frame(std::array<Pca9685, kNixiePcaCount> &pca)
+{
+    // Half the guard band on each side, so drift either way stays dark
+    const uint16_t lit = kStaggeredWindowTicks - kStaggeredGuardTicks;
+
+    for (auto &chip : pca) {
+        chip.stage_all_off();
+    }
+    for (size_t tube = 0; tube < kBoard.tube_map.size(); ++tube) {
+        const uint8_t numeral = scan_frame_.digits[tube] % 10;
+        const uint16_t width = static_cast<uint16_t>((static_cast<uint32_t>(duty_table_[tube][numeral]) * lit) / 4095);
+        if (width == 0) {
+            continue;
+        }
+        const NixieChannel ref = kBoard.tube_map[tube][numeral];
+        const uint16_t on = static_cast<uint16_t>(tube * kStaggeredWindowTicks + kStaggeredGuardTicks / 2);
+        pca[ref.chip_index].stage_pwm(ref.channel, on, static_cast<uint16_t>(on + width));
+    }
+    for (auto &chip : pca) {
+        chip.flush();
+    }
+}
+
+void NixieDriver::record_frame_bytes(const std::array<Pca9685, kNixiePcaCount> &pca, const Pca9685Group &group)
+{
+    uint32_t total = group.bytes_written();
+    for (const auto &chip : pca) {
+        total += chip.bytes_written();
+    }
+    const uint32_t frame_bytes = total - frame_start_bytes_;
+    frame_start_bytes_ = total;
+
+    const uint32_t allocations = HeapMonitor::allocation_count(heap_slot_);
+    const uint32_t frame_allocations = allocations - frame_start_allocations_;
+    frame_start_allocations_ = allocations;
+
+    scan_stats_.frames++;
+    scan_stats_.last_frame_bytes = frame_bytes;
+    scan_stats_.max_frame_bytes = std::max(scan_stats_.max_frame_bytes, frame_bytes);
+    scan_stats_.last_frame_allocations = frame_allocations;
+    scan_stats_published_.publish(scan_stats_);
+    if (scan_stats_.frames % kScanFrameHz == 0) {
+        ESP_LOGD(kTag, "I2C bytes/frame: %lu (max %lu), heap allocs/frame: %lu",
+                 static_cast<unsigned long>(frame_bytes),
+                 static_cast<unsigned long>(scan_stats_.max_frame_bytes),
+                 static_cast<unsigned long>(frame_allocations));
+    }
+}
+
+void NixieDriver::record_slot_timing(uint32_t start_us, uint32_t missed)
+{
+    const uint32_t error_us = static_cast<uint32_t>(esp_timer_get_time()) - start_us;
+
+    size_t bin = 0;
+    while (bin < kNixieSlotErrorBinsUs.size() && error_us > kNixieSlotErrorBinsUs[bin]) {
+        ++bin;
+    }
+    scan_stats_.slots++;
+    scan_stats_.missed_slots += missed;
+    scan_stats_.max_slot_error_us = std::max(scan_stats_.max_slot_error_us, error_us);
+    scan_stats_.slot_error_histogram[bin]++;
 }
@@ -5,6 +5,8 @@
 namespace {
 constexpr const char *kNamespace = "clock_cfg";
 constexpr const char *kBlobKey = "settings";
+constexpr const char *kCalibrationKey = "nixie_cal";
+constexpr const char *kWearKey = "nixie_wear";
 }
 
 SettingsStore::SettingsStore() = default;
@@ -72,3 +74,99 @@ bool SettingsStore::save(const ClockSettings &settings)
 
     return err == ESP_OK;
 }
+
+bool SettingsStore::load_calibration(NixieCalibration *out_calibration)
+{
+    if (!out_calibration) {
+        return false;
+    }
+
+    NixieCalibration calibration = uniform_nixie_calibration();
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNamespace, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        *out_calibration = calibration;
+        return true;
+    }
+    if (err != ESP_OK) {
+        return false;
+    }
+
+    size_t required_size = sizeof(NixieCalibration);
+    err = nvs_get_blob(handle, kCalibrationKey, calibration.data(), &required_size);
+    nvs_close(handle);
+
+    if (err == ESP_OK && required_size == sizeof(NixieCalibration)) {
+        *out_calibration = calibration;
+        return true;
+    }
+
+    *out_calibration = uniform_nixie_calibration();
+    return err == ESP_ERR_NVS_NOT_FOUND;
+}
+
+bool SettingsStore::save_calibration(const NixieCalibration &calibration)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNamespace, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return false;
+    }
+
+    err = nvs_set_blob(handle, kCalibrationKey, calibration.data(), sizeof(NixieCalibration));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return err == ESP_OK;
+}
+
+bool SettingsStore::load_wear(NixieWear *out_wear)
+{
+    if (!out_wear) {
+        return false;
+    }
+
+    NixieWear wear{};
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNamespace, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        *out_wear = wear;
+        return true;
+    }
+    if (err != ESP_OK) {
+        return false;
+    }
+
+    size_t required_size = sizeof(NixieWear);
+    err = nvs_get_blob(handle, kWearKey, wear.data(), &required_size);
+    nvs_close(handle);
+
+    if (err == ESP_OK && required_size == sizeof(NixieWear)) {
+        *out_wear = wear;
+        return true;
+    }
+
+    *out_wear = NixieWear{};
+    return err == ESP_ERR_NVS_NOT_FOUND;
+}
+
+bool SettingsStore::save_wear(const NixieWear &wear)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(kNamespace, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return false;
+    }
+
+    err = nvs_set_blob(handle, kWearKey, wear.data(), sizeof(NixieWear));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return err == ESP_OK;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include "nixie_tube.h"
 
 struct ClockSettings {
     int8_t tz_offset_hours;
@@ -23,5 +24,13 @@ public:
     bool load(ClockSettings *out_settings);
     bool save(const ClockSettings &settings);
 
+    // Kept apart from ClockSettings so tuning does not rewrite the settings
+    bool load_calibration(NixieCalibration *out_calibration);
+    bool save_calibration(const NixieCalibration &calibration);
+
+    // Cathode on-time counters; callers coalesce, this writes every time
+    bool load_wear(NixieWear *out_wear);
+    bool save_wear(const NixieWear &wear);
+
     static ClockSettings defaults();
 };
@@ -1,10 +1,13 @@
 #include "system_controller.h"
 #include "esp_log.h"
+#include <algorithm>
 #include <ctime>
 #include "settings_store.h"
 #include "driver/i2c.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
+#include "i2c_bus/i2c_bus.h"
+#include "ws2812.h"
 
 static const char *TAG = "SystemController";
 
@@ -22,7 +25,31 @@ constexpr int kUartBaudRate = 9600;
 constexpr gpio_num_t kRtcIntPin = static_cast<gpio_num_t>(8);
 constexpr gpio_num_t kPca9685OePin = static_cast<gpio_num_t>(4);
 constexpr gpio_num_t kLedDataInPin = static_cast<gpio_num_t>(7);
-constexpr uint32_t kRmtResolutionHz = 40000000; // 25ns resolution
+
+constexpr UBaseType_t kQueueLength = 10;
+constexpr uint64_t kTickPeriodUs = 1000000; // time update every second
+// With no SQW edge for this long the esp_timer tick takes over
+constexpr uint32_t kRtcEdgeTimeoutUs = 1500000;
+// Edges between time-register reads; in between the held time is stepped
+constexpr uint32_t kRtcResyncTicks = 60;
+
+namespace
+{
+// Steps h:m:s on by |seconds|; false at midnight, where the date needs
+// reading back
+bool advance_seconds(struct tm &time, uint32_t seconds)
+{
+    const uint32_t second_of_day =
+        static_cast<uint32_t>(time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec) + seconds;
+    if (second_of_day >= 86400) {
+        return false;
+    }
+    time.tm_hour = static_cast<int>(second_of_day / 3600);
+    time.tm_min = static_cast<int>(second_of_day / 60 % 60);
+    time.tm_sec = static_cast<int>(second_of_day % 60);
+    return true;
+}
+} // namespace
 
 HardwareHandles SystemController::init_hardware()
 {
@@ -39,6 +66,7 @@ HardwareHandles SystemController::init_hardware()
     i2c_conf.master.clk_speed = kI2cClockHz;
     ESP_ERROR_CHECK(i2c_param_config(kI2cPort, &i2c_conf));
     ESP_ERROR_CHECK(i2c_driver_install(kI2cPort, i2c_conf.mode, 0, 0, 0));
+    I2cBus::install(kI2cPort);
     handles.i2c_port = kI2cPort;
     ESP_LOGI(TAG, "I2C Initialized");
 
@@ -82,13 +110,13 @@ HardwareHandles SystemController::init_hardware()
     rmt_tx_channel_config_t rmt_config = {
         .gpio_num = kLedDataInPin,
         .clk_src = RMT_CLK_SRC_DEFAULT,
-        .resolution_hz = kRmtResolutionHz,
-        .mem_block_symbols = 64,
+        .resolution_hz = kWs2812RmtResolutionHz,
+        .mem_block_symbols = 256, // DMA buffer, refilled by the streaming encoder
         .trans_queue_depth = 4,
         .intr_priority = 0,
         .flags = {
             .invert_out = 0,
-            .with_dma = 0,
+            .with_dma = 1,
             .io_loop_back = 0,
             .io_od_mode = 0,
             .allow_pd = 0,
@@ -96,10 +124,8 @@ HardwareHandles SystemController::init_hardware()
     };
     ESP_ERROR_CHECK(rmt_new_tx_channel(&rmt_config, &handles.led_rmt_channel));
 
-    rmt_copy_encoder_config_t encoder_config = {};
-    ESP_ERROR_CHECK(rmt_new_copy_encoder(&encoder_config, &handles.led_rmt_encoder));
-    
-    ESP_ERROR_CHECK(rmt_enable(handles.led_rmt_channel));
+    ESP_ERROR_CHECK(Ws2812Strip::new_encoder(&handles.led_rmt_encoder));
+    // Left disabled: Ws2812Strip registers its done callback and enables it
     ESP_LOGI(TAG, "RMT Initialized");
 
 
@@ -112,14 +138,25 @@ SystemController::SystemController(DisplayDaemon &display_daemon, AudioDaemon &a
       audio_daemon_(audio_daemon),
       queue_(nullptr),
       task_handle_(nullptr),
+      tick_(nullptr),
+      queue_set_(nullptr),
+      tick_timer_(nullptr),
       rtc_(kI2cPort),
       settings_(SettingsStore::defaults())
 {
-    queue_ = xQueueCreate(10, sizeof(SystemMessage));
+    queue_ = xQueueCreate(kQueueLength, sizeof(SystemMessage));
+    tick_ = xSemaphoreCreateBinary();
+    // Room for every message plus the tick, as the set requires
+    queue_set_ = xQueueCreateSet(kQueueLength + 1);
+    xQueueAddToSet(queue_, queue_set_);
+    xQueueAddToSet(tick_, queue_set_);
     
     if (rtc_.init()) {
         ESP_LOGI(TAG, "RTC Initialized");
-        // Optional: Sync system time from RTC here
+        // 1 Hz on INT/SQW: the falling edge is the seconds roll-over
+        if (!rtc_.enable_square_wave(Ds3231SquareWave::HZ_1)) {
+            ESP_LOGW(TAG, "RTC square wave not enabled, ticking from esp_timer");
+        }
     } else {
         ESP_LOGE(TAG, "RTC Initialization Failed");
     }
@@ -127,9 +164,22 @@ SystemController::SystemController(DisplayDaemon &display_daemon, AudioDaemon &a
 
 SystemController::~SystemController()
 {
+    gpio_isr_handler_remove(kRtcIntPin);
+    if (tick_timer_) {
+        esp_timer_stop(tick_timer_);
+        esp_timer_delete(tick_timer_);
+    }
     if (task_handle_) {
         vTaskDelete(task_handle_);
     }
+    if (queue_set_) {
+        xQueueRemoveFromSet(queue_, queue_set_);
+        xQueueRemoveFromSet(tick_, queue_set_);
+        vQueueDelete(queue_set_);
+    }
+    if (tick_) {
+        vSemaphoreDelete(tick_);
+    }
     if (queue_) {
         vQueueDelete(queue_);
     }
@@ -138,6 +188,70 @@ SystemController::~SystemController()
 void SystemController::start()
 {
     xTaskCreate(task_entry, "system_controller", 4096, this, 5, &task_handle_);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = on_tick,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "system_tick",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &tick_timer_));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(tick_timer_, kTickPeriodUs));
+
+    // Already installed is fine: the service is shared by every GPIO ISR
+    const esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(err);
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add(kRtcIntPin, on_rtc_edge, this));
+}
+
+void SystemController::on_tick(void *param)
+{
+    auto *controller = static_cast<SystemController *>(param);
+    const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+    if (controller->rtc_edge_seen_.load(std::memory_order_relaxed) &&
+        now_us - controller->rtc_edge_us_.load(std::memory_order_relaxed) < kRtcEdgeTimeoutUs) {
+        return;
+    }
+    controller->tick_us_.store(now_us, std::memory_order_relaxed);
+    xSemaphoreGive(controller->tick_);
+}
+
+void IRAM_ATTR SystemController::on_rtc_edge(void *param)
+{
+    auto *controller = static_cast<SystemController *>(param);
+    const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+    controller->rtc_edge_us_.store(now_us, std::memory_order_relaxed);
+    controller->rtc_edge_seen_.store(true, std::memory_order_relaxed);
+    controller->tick_us_.store(now_us, std::memory_order_relaxed);
+    // Counted here because the semaphore merges edges the task is late for
+    controller->rtc_edge_count_.fetch_add(1, std::memory_order_release);
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(controller->tick_, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+SystemControllerStats SystemController::get_stats() const
+{
+    SystemControllerStats stats;
+    published_stats_.read(stats);
+    return stats;
+}
+
+void SystemController::reset_stats()
+{
+    // Cleared by the controller task, the only writer
+    stats_reset_requested_ = true;
+}
+
+void SystemController::record(SystemLatency &latency, uint32_t latency_us)
+{
+    latency.handled++;
+    latency.max_us = std::max(latency.max_us, latency_us);
+    latency.total_us += latency_us;
 }
 
 QueueHandle_t SystemController::get_queue() const
@@ -145,6 +259,11 @@ QueueHandle_t SystemController::get_queue() const
     return queue_;
 }
 
+const ClockService &SystemController::clock() const
+{
+    return clock_;
+}
+
 void SystemController::task_entry(void *param)
 {
     auto *controller = static_cast<SystemController *>(param);
@@ -154,21 +273,54 @@ void SystemController::task_entry(void *param)
 void SystemController::loop()
 {
     ESP_LOGI(TAG, "System Controller Started");
-    
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t update_interval = pdMS_TO_TICKS(1000); // Update time every second
+
+    // Show the time now rather than on the first tick
+    update_time(0, esp_timer_get_time());
 
     while (true) {
-        SystemMessage msg;
-        // Check for system events (buttons, etc.)
-        if (xQueueReceive(queue_, &msg, 0) == pdTRUE) {
-            process_message(msg);
-        }
+        // One item per wake-up, as queue sets require; a backlog drains
+        // back to back because the set stays ready until it is empty
+        QueueSetMemberHandle_t ready = xQueueSelectFromSet(queue_set_, portMAX_DELAY);
 
-        // Periodic tasks
-        update_time();
+        if (stats_reset_requested_.exchange(false)) {
+            stats_ = {};
+        }
 
-        vTaskDelayUntil(&last_wake_time, update_interval);
+        if (ready == queue_) {
+            const uint32_t depth = uxQueueMessagesWaiting(queue_);
+            stats_.max_queue_depth = std::max(stats_.max_queue_depth, depth);
+            SystemMessage msg;
+            if (xQueueReceive(queue_, &msg, 0) == pdTRUE) {
+                process_message(msg);
+                const size_t event = static_cast<size_t>(msg.event);
+                const int64_t elapsed_us = esp_timer_get_time() - msg.enqueued_us;
+                if (event < stats_.events.size()) {
+                    record(stats_.events[event], elapsed_us > 0 ? static_cast<uint32_t>(elapsed_us) : 0);
+                }
+            }
+        } else if (ready == tick_) {
+            xSemaphoreTake(tick_, 0);
+            const uint32_t edges = rtc_edge_count_.exchange(0, std::memory_order_acquire);
+            if (edges > 0) {
+                stats_.rtc_edges += edges;
+            } else if (rtc_edge_seen_.load(std::memory_order_relaxed) &&
+                       static_cast<uint32_t>(esp_timer_get_time()) - rtc_edge_us_.load(std::memory_order_relaxed) <
+                           kRtcEdgeTimeoutUs) {
+                // An edge counted by the previous pass gave the semaphore again
+                published_stats_.publish(stats_);
+                continue;
+            } else {
+                stats_.fallback_ticks++;
+            }
+            // The stamp is the low 32 bits of esp_timer; widen it against now
+            const int64_t now_us = esp_timer_get_time();
+            const int64_t tick_us =
+                now_us - (static_cast<uint32_t>(now_us) - tick_us_.load(std::memory_order_relaxed));
+            // Periodic tasks
+            update_time(edges, tick_us);
+            record(stats_.tick, static_cast<uint32_t>(esp_timer_get_time() - tick_us));
+        }
+        published_stats_.publish(stats_);
     }
 }
 
@@ -178,45 +330,31 @@ void SystemController::process_message(const SystemMessage &msg)
         case SystemEvent::BUTTON_PRESSED:
             ESP_LOGI(TAG, "Button pressed: %d", msg.data.button_id);
             // Example: Toggle effect on button press
-            // DisplayMessage dmsg;
-            // dmsg.command = DisplayCmd::SET_EFFECT;
-            // ...
-            // xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
+            // display_daemon_.state().set_effect(...);
+            break;
+        case SystemEvent::ALARM_TRIGGERED:
+            display_daemon_.state().flash({255, 255, 255}, 5);
             break;
         case SystemEvent::CLI_COMMAND:
             if (msg.data.cli.type == CliCommandType::SET_NIXIE) {
-                DisplayMessage dmsg;
-                dmsg.command = DisplayCmd::SET_MODE;
-                dmsg.data.mode = DisplayMode::MANUAL_DISPLAY;
-                xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
-
-                dmsg.command = DisplayCmd::SET_MANUAL_NUMBER;
-                dmsg.data.number = msg.data.cli.value;
-                xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
+                display_daemon_.state().show_number(msg.data.cli.value);
             } else if (msg.data.cli.type == CliCommandType::SET_BACKLIGHT) {
-                if (msg.data.cli.backlight.has_color) {
-                    DisplayMessage dmsg;
-                    dmsg.command = DisplayCmd::SET_BACKLIGHT_COLOR;
-                    dmsg.data.color.r = msg.data.cli.backlight.r;
-                    dmsg.data.color.g = msg.data.cli.backlight.g;
-                    dmsg.data.color.b = msg.data.cli.backlight.b;
-                    xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
-                }
-                if (msg.data.cli.backlight.has_brightness) {
-                    DisplayMessage dmsg;
-                    dmsg.command = DisplayCmd::SET_BACKLIGHT_BRIGHTNESS;
-                    dmsg.data.brightness = msg.data.cli.backlight.brightness;
-                    xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
-                }
+                // Tube 0 is every tube; colour and brightness go in one write
+                const RgbColor color = {msg.data.cli.backlight.r, msg.data.cli.backlight.g,
+                                        msg.data.cli.backlight.b};
+                display_daemon_.state().set_backlight(
+                    static_cast<int>(msg.data.cli.backlight.tube) - 1,
+                    msg.data.cli.backlight.has_color ? &color : nullptr,
+                    msg.data.cli.backlight.has_brightness ? &msg.data.cli.backlight.brightness : nullptr);
+            } else if (msg.data.cli.type == CliCommandType::SET_EFFECT) {
+                display_daemon_.state().set_effect(msg.data.cli.effect_id);
+            } else if (msg.data.cli.type == CliCommandType::SET_TRANSITION) {
+                display_daemon_.state().set_transition(msg.data.cli.transition.type,
+                                                       msg.data.cli.transition.duration_ms);
             }
             break;
         case SystemEvent::BATTERY_UPDATE:
-            {
-                DisplayMessage dmsg;
-                dmsg.command = DisplayCmd::UPDATE_BATTERY;
-                dmsg.data.battery = msg.data.battery;
-                xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
-            }
+            display_daemon_.state().set_battery(msg.data.battery);
             break;
         case SystemEvent::POWER_UPDATE:
             {
@@ -244,55 +382,76 @@ void SystemController::apply_settings(const ClockSettings &settings, const struc
             localtime_r(&epoch, &adjusted);
         }
         rtc_.set_time(&adjusted);
+        resync_requested_ = true;
     }
 
-    DisplayMessage dmsg = {};
-    dmsg.command = DisplayCmd::SET_BACKLIGHT_COLOR;
-    dmsg.data.color.r = settings.backlight_r;
-    dmsg.data.color.g = settings.backlight_g;
-    dmsg.data.color.b = settings.backlight_b;
-    xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
-
-    dmsg.command = DisplayCmd::SET_BACKLIGHT_BRIGHTNESS;
-    dmsg.data.brightness = settings.backlight_brightness;
-    xQueueSend(display_daemon_.get_queue(), &dmsg, 0);
+    const RgbColor backlight = {settings.backlight_r, settings.backlight_g, settings.backlight_b};
+    display_daemon_.state().set_backlight(-1, &backlight, &settings.backlight_brightness);
 
     AudioMessage amsg = {};
     amsg.command = AudioCmd::SET_VOLUME;
     amsg.param.volume = settings.volume;
     xQueueSend(audio_daemon_.get_queue(), &amsg, 0);
 
+    alarm_armed_ = false;
     if (settings.alarm_enabled) {
         struct tm alarm = {};
         alarm.tm_hour = settings.alarm_hour;
         alarm.tm_min = settings.alarm_minute;
         alarm.tm_sec = settings.alarm_second;
-        alarm.tm_mday = 1;
-        rtc_.set_alarm1(&alarm);
+        rtc_.set_alarm1_daily(&alarm);
         rtc_.clear_alarm1_flag();
         rtc_.enable_alarm1_interrupt(true);
+        alarm_armed_ = true;
     } else {
         rtc_.enable_alarm1_interrupt(false);
         rtc_.clear_alarm1_flag();
     }
 }
 
-void SystemController::update_time()
+bool SystemController::read_rtc(int64_t &read_us)
 {
-    // Get current time from RTC
-    struct tm timeinfo;
-    if (rtc_.get_time(&timeinfo)) {
-        // Send time update to Display Daemon
-        DisplayMessage msg;
-        msg.command = DisplayCmd::UPDATE_TIME;
-        msg.data.time.h = timeinfo.tm_hour;
-        msg.data.time.m = timeinfo.tm_min;
-        msg.data.time.s = timeinfo.tm_sec;
-        
-        xQueueSend(display_daemon_.get_queue(), &msg, 0);
-    } else {
+    read_us = esp_timer_get_time();
+    time_valid_ = rtc_.get_time(&now_);
+    ticks_since_read_ = 0;
+    stats_.rtc_reads++;
+    if (!time_valid_) {
         ESP_LOGW(TAG, "Failed to read time from RTC");
     }
+    return time_valid_;
+}
+
+void SystemController::update_time(uint32_t edges, int64_t tick_us)
+{
+    // The registers are only read every kRtcResyncTicks edges, after the
+    // time was set, and without edges to count
+    const bool on_edge = edges > 0;
+    const bool resync = resync_requested_.exchange(false);
+    ticks_since_read_ += edges;
+    const bool stepped = on_edge && time_valid_ && !resync && ticks_since_read_ < kRtcResyncTicks &&
+                         advance_seconds(now_, edges);
+    int64_t read_us = tick_us;
+    if (!stepped && !read_rtc(read_us)) {
+        return;
+    }
+
+    // An edge pins the second's start; a plain read only which second it is
+    if (on_edge) {
+        // A counted second a step away from the clock means an edge was lost
+        // or doubled; the registers decide rather than the count
+        if (!clock_.sync_edge(ClockService::wall_seconds(now_), tick_us, stepped)) {
+            if (!read_rtc(read_us)) {
+                return;
+            }
+            clock_.sync_edge(ClockService::wall_seconds(now_), tick_us);
+        }
+    } else {
+        clock_.sync_coarse(ClockService::wall_seconds(now_), read_us);
+    }
+
+    // Send time update to Display Daemon
+    display_daemon_.state().set_time(now_.tm_hour, now_.tm_min, now_.tm_sec);
+    check_alarm();
     
     /*
     // Fallback or original logic if needed
@@ -302,3 +461,18 @@ void SystemController::update_time()
     localtime_r(&now, &timeinfo_sys);
     */
 }
+
+void SystemController::check_alarm()
+{
+    bool fired = false;
+    if (!alarm_armed_ || !rtc_.alarm1_fired(&fired) || !fired) {
+        return;
+    }
+    rtc_.clear_alarm1_flag();
+
+    SystemMessage msg = {};
+    msg.event = SystemEvent::ALARM_TRIGGERED;
+    if (post_system_message(queue_, msg) != pdTRUE) {
+        ESP_LOGW(TAG, "System queue full, dropped alarm");
+    }
+}
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/rmt_tx.h"
 #include "driver/rmt_encoder.h"
 #include "driver/uart.h"
@@ -11,6 +15,8 @@
 #include "daemons/audio_daemon.h"
 #include "ds3231/ds3231.h"
 #include "settings_store.h"
+#include "frame_buffer.h"
+#include "clock_service.h"
 
 struct HardwareHandles {
     i2c_port_t i2c_port;
@@ -19,6 +25,24 @@ struct HardwareHandles {
     uart_port_t audio_uart_port;
 };
 
+// Enqueue-to-handle latency of one kind of work
+struct SystemLatency
+{
+    uint32_t handled;
+    uint32_t max_us;
+    uint64_t total_us;
+};
+
+struct SystemControllerStats
+{
+    std::array<SystemLatency, kSystemEventCount> events; // by SystemEvent
+    SystemLatency tick; // periodic work, from the tick firing
+    uint32_t max_queue_depth;
+    uint32_t rtc_edges;      // ticks from the DS3231 1 Hz SQW
+    uint32_t fallback_ticks; // esp_timer ticks while no edges arrived
+    uint32_t rtc_reads;      // time-register reads over I2C
+};
+
 class SystemController
 {
 public:
@@ -29,20 +53,56 @@ public:
 
     void start();
     QueueHandle_t get_queue() const;
+    // Safe to call from any task
+    SystemControllerStats get_stats() const;
+    void reset_stats();
+    // Millisecond wall time disciplined to the RTC; readable from any task
+    const ClockService &clock() const;
     void apply_settings(const ClockSettings &settings, const struct tm *new_time);
 
 private:
     static void task_entry(void *param);
     void loop();
     void process_message(const SystemMessage &msg);
-    void update_time();
+    // edges: RTC roll-overs since the last call, the newest at tick_us, so
+    // the held time may be stepped by that many seconds instead of read back
+    void update_time(uint32_t edges, int64_t tick_us);
+    // Reads the time registers into now_, stamping read_us just before
+    bool read_rtc(int64_t &read_us);
+    // Posts ALARM_TRIGGERED once the RTC has raised A1F
+    void check_alarm();
+    static void on_tick(void *param);
+    static void on_rtc_edge(void *param);
+    void record(SystemLatency &latency, uint32_t latency_us);
 
     DisplayDaemon &display_daemon_;
     AudioDaemon &audio_daemon_;
     QueueHandle_t queue_;
     TaskHandle_t task_handle_;
+    // The task blocks on both: messages wake it at once, the tick paces
+    // the periodic work. The SQW edge gives the tick; the esp_timer only
+    // stands in while no edges arrive.
+    SemaphoreHandle_t tick_;
+    QueueSetHandle_t queue_set_;
+    esp_timer_handle_t tick_timer_;
+    std::atomic<uint32_t> tick_us_{0};
+    std::atomic<uint32_t> rtc_edge_count_{0};
+    std::atomic<uint32_t> rtc_edge_us_{0};
+    std::atomic<bool> rtc_edge_seen_{false};
+
+    SystemControllerStats stats_{};
+    FrameBuffer<SystemControllerStats> published_stats_;
+    std::atomic<bool> stats_reset_requested_{false};
     
     // State
     Ds3231 rtc_;
     ClockSettings settings_;
+    ClockService clock_;
+    struct tm now_{};
+    bool time_valid_ = false;
+    uint32_t ticks_since_read_ = 0;
+    // Set when the RTC was written from another task
+    std::atomic<bool> resync_requested_{false};
+    // INT/SQW carries the seconds edge, so the alarm is polled, not wired
+    std::atomic<bool> alarm_armed_{false};
 };
@@ -0,0 +1,50 @@
+#include "temporal_dither.h"
+#include <algorithm>
+
+namespace
+{
+// Returns the OR of the fractions, non-zero if any pixel is dithering
+inline uint32_t dither_plane(const std::array<uint16_t, kBacklightLedCount> &target,
+                             std::array<uint8_t, kBacklightLedCount> &error,
+                             std::array<uint8_t, kBacklightLedCount> &out,
+                             uint16_t round, uint16_t mask)
+{
+    uint32_t fractions = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        // target tops out at 0xFF00, a whole step, so rounding stays below
+        // it and the sum never passes 0xFFFF
+        const uint32_t level = (target[i] + round) & mask;
+        const uint32_t sum = level + error[i];
+        out[i] = static_cast<uint8_t>(sum >> 8);
+        error[i] = static_cast<uint8_t>(sum);
+        fractions |= level & 0xFF;
+    }
+    return fractions;
+}
+
+// Different starting error per LED and channel, so neighbours at the same
+// level step on different frames instead of pulsing together
+void seed(std::array<uint8_t, kBacklightLedCount> &error, uint32_t offset)
+{
+    for (size_t i = 0; i < error.size(); ++i) {
+        error[i] = static_cast<uint8_t>(i * 157 + offset);
+    }
+}
+} // namespace
+
+TemporalDither::TemporalDither(uint8_t depth)
+    : round_(static_cast<uint16_t>((0x100 >> std::min<uint8_t>(depth, 8)) >> 1)),
+      mask_(static_cast<uint16_t>(~((0x100 >> std::min<uint8_t>(depth, 8)) - 1)))
+{
+    seed(red_error_, 0);
+    seed(green_error_, 85);
+    seed(blue_error_, 170);
+}
+
+bool TemporalDither::apply(const LedPixels &target, LedOutput &out)
+{
+    uint32_t fractions = dither_plane(target.red, red_error_, out.red, round_, mask_);
+    fractions |= dither_plane(target.green, green_error_, out.green, round_, mask_);
+    fractions |= dither_plane(target.blue, blue_error_, out.blue, round_, mask_);
+    return fractions != 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "led_compositor.h"
+
+using LedOutput = RgbFrame<kBacklightLedCount>;
+
+// Frame-rate dithering from 8.8 levels down to the strip's 8 bits. Each
+// channel carries the fraction its output dropped into the next frame
+// (first-order error diffusion over time), so over any 2^depth frames a
+// level is shown for its value rounded to depth fraction bits. Inputs 2-14
+// gamma-correct to 0 in 8 bits (1 is 0 even in 8.8); this is what lets them
+// show, as far as the depth reaches.
+class TemporalDither
+{
+public:
+    // A pattern repeats every 2^depth frames at most, so this is the
+    // slowest repeat the depth may give; slower reads as blinking
+    static constexpr uint32_t kMinCycleHz = 25;
+
+    // Fraction bits the frame rate can hide, 0..8
+    static constexpr uint8_t depth_for_rate(uint32_t frame_rate_hz)
+    {
+        uint8_t depth = 0;
+        while (depth < 8 && (frame_rate_hz >> (depth + 1)) >= kMinCycleHz) {
+            ++depth;
+        }
+        return depth;
+    }
+
+    explicit TemporalDither(uint8_t depth = 8);
+
+    // Writes the next 8-bit frame for target. Returns true while some
+    // channel has a fraction, i.e. the output keeps changing and apply()
+    // has to run every frame even if the target does not.
+    bool apply(const LedPixels &target, LedOutput &out);
+
+private:
+    uint16_t round_; // half a step of the kept fraction
+    uint16_t mask_;  // clears the fraction bits below the depth
+    std::array<uint8_t, kBacklightLedCount> red_error_;
+    std::array<uint8_t, kBacklightLedCount> green_error_;
+    std::array<uint8_t, kBacklightLedCount> blue_error_;
+};
@@ -218,10 +218,83 @@ static esp_err_t settings_post_handler(httpd_req_t *req)
     httpd_resp_set_type(req, "text/plain");
     return httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
 }
+
+static esp_err_t calibration_get_handler(httpd_req_t *req)
+{
+    auto *server = static_cast<WebServer *>(req->user_ctx);
+    const NixieCalibration calibration = server->get_calibration();
+
+    // {"levels":[[l0,...,l9],...]}, one row of ten 0-255 levels per tube
+    std::string response = "{\"levels\":[";
+    for (size_t t = 0; t < calibration.size(); ++t) {
+        response += (t == 0) ? "[" : ",[";
+        for (size_t d = 0; d < calibration[t].size(); ++d) {
+            if (d > 0) {
+                response += ",";
+            }
+            response += std::to_string(calibration[t][d]);
+        }
+        response += "]";
+    }
+    response += "]}";
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response.c_str(), response.size());
+}
+
+static esp_err_t calibration_post_handler(httpd_req_t *req)
+{
+    auto *server = static_cast<WebServer *>(req->user_ctx);
+    std::string body;
+    body.resize(req->content_len);
+    int received = httpd_req_recv(req, body.data(), body.size());
+    if (received <= 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read body");
+        return ESP_FAIL;
+    }
+
+    // {"tube":1-n,"digit":0-9,"level":0-255}; a missing tube or digit
+    // applies the level to all of them
+    std::string level_value = extract_json_value(body, "level");
+    if (level_value.empty()) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing level");
+        return ESP_FAIL;
+    }
+    const int level = std::stoi(level_value);
+    std::string tube_value = extract_json_value(body, "tube");
+    const int tube = tube_value.empty() ? 0 : std::stoi(tube_value);
+    std::string digit_value = extract_json_value(body, "digit");
+    const int digit = digit_value.empty() ? -1 : std::stoi(digit_value);
+    NixieCalibration calibration = server->get_calibration();
+    if (level < 0 || level > 255 || tube < 0 || static_cast<size_t>(tube) > calibration.size() || digit < -1 ||
+        digit > 9) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Value out of range");
+        return ESP_FAIL;
+    }
+
+    for (size_t t = 0; t < calibration.size(); ++t) {
+        if (tube != 0 && t != static_cast<size_t>(tube - 1)) {
+            continue;
+        }
+        for (size_t d = 0; d < calibration[t].size(); ++d) {
+            if (digit < 0 || d == static_cast<size_t>(digit)) {
+                calibration[t][d] = static_cast<uint8_t>(level);
+            }
+        }
+    }
+
+    if (!server->apply_calibration(calibration)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save calibration");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
+}
 }
 
-WebServer::WebServer(SystemController &system_controller, SettingsStore &store)
-    : system_controller_(system_controller), store_(store), task_handle_(nullptr)
+WebServer::WebServer(SystemController &system_controller, SettingsStore &store, INixieDriver &nixie_driver)
+    : system_controller_(system_controller), store_(store), nixie_driver_(nixie_driver), task_handle_(nullptr)
 {
 }
 
@@ -347,9 +420,25 @@ bool WebServer::start_http()
         .user_ctx = this,
     };
 
+    httpd_uri_t calibration_get = {
+        .uri = "/api/nixie_cal",
+        .method = HTTP_GET,
+        .handler = calibration_get_handler,
+        .user_ctx = this,
+    };
+
+    httpd_uri_t calibration_post = {
+        .uri = "/api/nixie_cal",
+        .method = HTTP_POST,
+        .handler = calibration_post_handler,
+        .user_ctx = this,
+    };
+
     httpd_register_uri_handler(g_http, &index_uri);
     httpd_register_uri_handler(g_http, &settings_get);
     httpd_register_uri_handler(g_http, &settings_post);
+    httpd_register_uri_handler(g_http, &calibration_get);
+    httpd_register_uri_handler(g_http, &calibration_post);
     return true;
 }
 
@@ -374,3 +463,15 @@ bool WebServer::apply_settings(const ClockSettings &settings, const struct tm *n
     system_controller_.apply_settings(settings, new_time);
     return true;
 }
+
+NixieCalibration WebServer::get_calibration() const
+{
+    return nixie_driver_.get_calibration();
+}
+
+bool WebServer::apply_calibration(const NixieCalibration &calibration)
+{
+    // Applied live first, so a failed save still leaves the tuning visible
+    nixie_driver_.set_calibration(calibration);
+    return store_.save_calibration(calibration);
+}
@@ -4,6 +4,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "settings_store.h"
+#include "nixie_driver.h"
 #include <ctime>
 
 class SystemController;
@@ -11,7 +12,7 @@ class SystemController;
 class WebServer
 {
 public:
-    WebServer(SystemController &system_controller, SettingsStore &store);
+    WebServer(SystemController &system_controller, SettingsStore &store, INixieDriver &nixie_driver);
     ~WebServer();
 
     void start();
@@ -19,6 +20,8 @@ public:
 
     bool load_settings(ClockSettings *out_settings);
     bool apply_settings(const ClockSettings &settings, const struct tm *new_time);
+    NixieCalibration get_calibration() const;
+    bool apply_calibration(const NixieCalibration &calibration);
 
 private:
     static void task_entry(void *param);
@@ -30,5 +33,6 @@ private:
 
     SystemController &system_controller_;
     SettingsStore &store_;
+    INixieDriver &nixie_driver_;
     TaskHandle_t task_handle_;
 };
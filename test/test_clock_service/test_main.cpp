@@ -0,0 +1,230 @@
+#include <unity.h>
+
+#include <cstdio>
+#include "clock_service.h"
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#endif
+
+// Runs on the target and on the host (pio test -e native)
+
+void setUp() {}
+void tearDown() {}
+
+// Same clock ClockService reads in now() and now_ms()
+static int64_t now_us()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+constexpr int64_t kStartWall = 1700000000;
+constexpr int64_t kStartLocal = 5000000;
+
+// esp_timer time of RTC second n when esp_timer runs ppm fast
+static int64_t edge_local(int64_t n, int64_t ppm)
+{
+    return kStartLocal + n * (1000000 + ppm);
+}
+
+void test_wall_seconds_matches_known_dates()
+{
+    struct tm epoch = {};
+    epoch.tm_year = 70;
+    epoch.tm_mday = 1;
+    TEST_ASSERT_EQUAL_INT64(0, ClockService::wall_seconds(epoch));
+
+    struct tm leap = {};
+    leap.tm_year = 124; // 2024-02-29 12:34:56
+    leap.tm_mon = 1;
+    leap.tm_mday = 29;
+    leap.tm_hour = 12;
+    leap.tm_min = 34;
+    leap.tm_sec = 56;
+    TEST_ASSERT_EQUAL_INT64(1709210096, ClockService::wall_seconds(leap));
+}
+
+void test_first_edge_steps_to_rtc()
+{
+    ClockService clock;
+    TEST_ASSERT_FALSE(clock.valid());
+    clock.sync_edge(kStartWall, kStartLocal);
+    TEST_ASSERT_TRUE(clock.valid());
+    TEST_ASSERT_EQUAL_INT64(kStartWall * 1000000 + 250000, clock.wall_us(kStartLocal + 250000));
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().steps);
+}
+
+void test_rate_converges_to_oscillator_error()
+{
+    // esp_timer 40 ppm fast: the RTC's second takes 1000040 us
+    ClockService clock;
+    for (int64_t n = 0; n <= 600; ++n) {
+        clock.sync_edge(kStartWall + n, edge_local(n, 40));
+    }
+    const ClockServiceStats stats = clock.stats();
+    TEST_ASSERT_INT32_WITHIN(2000, -40000, stats.rate_ppb);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.steps);
+
+    // Half a second past the last edge lands within a few microseconds
+    const int64_t expected = (kStartWall + 600) * 1000000 + 500000;
+    TEST_ASSERT_INT64_WITHIN(5, expected, clock.wall_us(edge_local(600, 40) + 500020));
+}
+
+void test_jittery_edges_never_run_backwards()
+{
+    ClockService clock;
+    int64_t last_us = INT64_MIN;
+    uint32_t seed = 1;
+    for (int64_t n = 0; n <= 300; ++n) {
+        // Up to 200 us of interrupt latency on each edge
+        seed = seed * 1103515245 + 12345;
+        const int64_t edge_us = edge_local(n, -25) + (seed >> 16) % 200;
+        clock.sync_edge(kStartWall + n, edge_us);
+        for (int64_t t = edge_us; t < edge_us + 1000000; t += 100000) {
+            const int64_t wall_us = clock.wall_us(t);
+            TEST_ASSERT_TRUE(wall_us >= last_us);
+            last_us = wall_us;
+        }
+    }
+    // Slewed to within the jitter of the RTC
+    TEST_ASSERT_INT32_WITHIN(300, 0, clock.stats().last_offset_us);
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().steps);
+}
+
+void test_time_set_steps()
+{
+    ClockService clock;
+    for (int64_t n = 0; n < 10; ++n) {
+        clock.sync_edge(kStartWall + n, edge_local(n, 0));
+    }
+    clock.sync_edge(kStartWall + 3600, edge_local(10, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, clock.stats().steps);
+    TEST_ASSERT_EQUAL_INT64((kStartWall + 3600) * 1000000, clock.wall_us(edge_local(10, 0)));
+}
+
+void test_stale_counted_second_is_refused()
+{
+    ClockService clock;
+    for (int64_t n = 0; n < 10; ++n) {
+        clock.sync_edge(kStartWall + n, edge_local(n, 0), n > 0);
+    }
+    // A lost edge leaves the count a second behind: not a step back
+    const int64_t before_us = clock.wall_us(edge_local(10, 0) - 1);
+    TEST_ASSERT_FALSE(clock.sync_edge(kStartWall + 9, edge_local(10, 0), true));
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().refused);
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().steps);
+    TEST_ASSERT_TRUE(clock.wall_us(edge_local(10, 0)) > before_us);
+
+    // The read-back agrees with the clock, so nothing steps
+    TEST_ASSERT_TRUE(clock.sync_edge(kStartWall + 10, edge_local(10, 0)));
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().steps);
+    TEST_ASSERT_EQUAL_INT64((kStartWall + 10) * 1000000, clock.wall_us(edge_local(10, 0)));
+}
+
+void test_offset_slews_out_in_a_few_seconds()
+{
+    ClockService clock;
+    clock.sync_edge(kStartWall, edge_local(0, 0));
+    // The clock turns out 40 ms ahead of the edges: 4 s of running 1% slow
+    clock.sync_edge(kStartWall + 1, edge_local(1, 0) + 40000, true);
+    int64_t last_us = INT64_MIN;
+    for (int64_t n = 2; n <= 6; ++n) {
+        for (int64_t t = edge_local(n - 1, 0) + 40000; t < edge_local(n, 0) + 40000; t += 10000) {
+            const int64_t wall_us = clock.wall_us(t);
+            TEST_ASSERT_TRUE(wall_us >= last_us);
+            last_us = wall_us;
+        }
+        clock.sync_edge(kStartWall + n, edge_local(n, 0) + 40000, true);
+    }
+    TEST_ASSERT_INT32_WITHIN(1000, 0, clock.stats().last_offset_us);
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().steps);
+}
+
+void test_coarse_sync_only_steps_outside_the_second()
+{
+    ClockService clock;
+    clock.sync_coarse(kStartWall, kStartLocal);
+    TEST_ASSERT_EQUAL_INT64(kStartWall * 1000000 + 500000, clock.wall_us(kStartLocal));
+
+    // Still within the second the RTC shows: left alone
+    clock.sync_coarse(kStartWall + 1, kStartLocal + 900000);
+    TEST_ASSERT_EQUAL_UINT32(1, clock.stats().steps);
+
+    // The RTC is a second ahead of the clock: pulled up to its second
+    clock.sync_coarse(kStartWall + 3, kStartLocal + 1900000);
+    TEST_ASSERT_EQUAL_UINT32(2, clock.stats().steps);
+    TEST_ASSERT_EQUAL_INT64((kStartWall + 3) * 1000000, clock.wall_us(kStartLocal + 1900000));
+}
+
+void test_now_breaks_down_wall_time()
+{
+    ClockService clock;
+    struct tm timeinfo = {};
+    uint16_t ms = 0;
+    TEST_ASSERT_FALSE(clock.now(&timeinfo, &ms));
+
+    // Anchored so that now lands on 2024-02-29 12:34:56
+    clock.sync_edge(1709210096, now_us());
+    TEST_ASSERT_TRUE(clock.now(&timeinfo, &ms));
+    TEST_ASSERT_EQUAL_INT(124, timeinfo.tm_year);
+    TEST_ASSERT_EQUAL_INT(1, timeinfo.tm_mon);
+    TEST_ASSERT_EQUAL_INT(29, timeinfo.tm_mday);
+    TEST_ASSERT_EQUAL_INT(4, timeinfo.tm_wday);
+    TEST_ASSERT_EQUAL_INT(12, timeinfo.tm_hour);
+    TEST_ASSERT_EQUAL_INT(34, timeinfo.tm_min);
+    TEST_ASSERT_EQUAL_INT(56, timeinfo.tm_sec);
+    TEST_ASSERT_TRUE(ms < 100);
+}
+
+void benchmark_now_ms()
+{
+    ClockService clock;
+    clock.sync_edge(kStartWall, now_us());
+    constexpr int kIterations = 10000;
+    int64_t sink = 0;
+    const int64_t start = now_us();
+    for (int i = 0; i < kIterations; ++i) {
+        sink += clock.now_ms();
+    }
+    const int64_t elapsed = now_us() - start;
+    printf("now_ms: %lld ns per call (%lld)\n", static_cast<long long>(elapsed * 1000 / kIterations),
+           static_cast<long long>(sink & 1));
+}
+
+static int run_tests()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_wall_seconds_matches_known_dates);
+    RUN_TEST(test_first_edge_steps_to_rtc);
+    RUN_TEST(test_rate_converges_to_oscillator_error);
+    RUN_TEST(test_jittery_edges_never_run_backwards);
+    RUN_TEST(test_time_set_steps);
+    RUN_TEST(test_stale_counted_second_is_refused);
+    RUN_TEST(test_offset_slews_out_in_a_few_seconds);
+    RUN_TEST(test_coarse_sync_only_steps_outside_the_second);
+    RUN_TEST(test_now_breaks_down_wall_time);
+    RUN_TEST(benchmark_now_ms);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    run_tests();
+}
+#else
+int main()
+{
+    return run_tests();
+}
+#endif
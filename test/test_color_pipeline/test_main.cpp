@@ -0,0 +1,158 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include "color_model.h"
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#endif
+
+// Runs on the target and on the host (pio test -e native)
+
+void setUp() {}
+void tearDown() {}
+
+static int64_t now_us()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+static int channel_error(const RgbColor &a, const RgbColor &b)
+{
+    const int red = std::abs(a.red - b.red);
+    const int green = std::abs(a.green - b.green);
+    const int blue = std::abs(a.blue - b.blue);
+    return red > green ? (red > blue ? red : blue) : (green > blue ? green : blue);
+}
+
+void test_fixed_primaries_are_exact()
+{
+    const HsvColor colors[] = {{0, 255, 255}, {120, 255, 255}, {240, 255, 255}, {0, 0, 200}, {0, 0, 0}};
+    for (const HsvColor &hsv : colors) {
+        TEST_ASSERT_EQUAL(0, channel_error(hsv_to_rgb(hsv), hsv_to_rgb_fixed(hsv)));
+    }
+}
+
+void test_fixed_within_error_bound_of_float()
+{
+    int worst = 0;
+    for (uint16_t hue = 0; hue < 360; ++hue) {
+        for (int saturation = 0; saturation <= 255; saturation += (saturation == 250) ? 5 : 10) {
+            for (int value = 0; value <= 255; value += (value == 250) ? 5 : 10) {
+                const HsvColor hsv{hue, static_cast<uint8_t>(saturation), static_cast<uint8_t>(value)};
+                const int error = channel_error(hsv_to_rgb(hsv), hsv_to_rgb_fixed(hsv));
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(kHsvFixedMaxError, worst);
+}
+
+void test_batch_matches_scalar_with_gamma()
+{
+    HsvFrame<36> in;
+    RgbFrame<36> out;
+    for (size_t i = 0; i < in.hue.size(); ++i) {
+        in.hue[i] = static_cast<uint16_t>(i * 10);
+        in.saturation[i] = static_cast<uint8_t>(255 - i * 3);
+        in.value[i] = static_cast<uint8_t>(40 + i * 6);
+    }
+    hsv_to_rgb_gamma(in.planes(), out.planes());
+    for (size_t i = 0; i < in.hue.size(); ++i) {
+        const RgbColor expected = apply_gamma(hsv_to_rgb_fixed({in.hue[i], in.saturation[i], in.value[i]}));
+        TEST_ASSERT_EQUAL_UINT8(expected.red, out.red[i]);
+        TEST_ASSERT_EQUAL_UINT8(expected.green, out.green[i]);
+        TEST_ASSERT_EQUAL_UINT8(expected.blue, out.blue[i]);
+    }
+}
+
+void test_batch_stops_at_shortest_plane()
+{
+    HsvFrame<4> in;
+    in.value.fill(255);
+    RgbFrame<4> out;
+    const RgbPlanes planes = out.planes();
+    hsv_to_rgb_gamma(in.planes(), {planes.red.first(2), planes.green, planes.blue});
+    TEST_ASSERT_EQUAL_UINT8(255, out.red[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, out.red[2]);
+    TEST_ASSERT_EQUAL_UINT8(0, out.green[2]);
+}
+
+// Not an assertion, just the numbers: per-pixel cost of the float path,
+// the fixed-point path and the batch pass (which also applies gamma)
+void test_benchmark_fixed_against_float()
+{
+    constexpr size_t kPixels = 360;
+    constexpr int kRounds = 20;
+    HsvFrame<kPixels> in;
+    RgbFrame<kPixels> out;
+    for (size_t i = 0; i < kPixels; ++i) {
+        in.hue[i] = static_cast<uint16_t>(i);
+        in.saturation[i] = static_cast<uint8_t>(i * 7);
+        in.value[i] = static_cast<uint8_t>(255 - i / 2);
+    }
+
+    uint32_t checksum = 0;
+    int64_t start = now_us();
+    for (int round = 0; round < kRounds; ++round) {
+        for (size_t i = 0; i < kPixels; ++i) {
+            checksum += apply_gamma(hsv_to_rgb({in.hue[i], in.saturation[i], in.value[i]})).red;
+        }
+    }
+    const int64_t float_us = now_us() - start;
+
+    start = now_us();
+    for (int round = 0; round < kRounds; ++round) {
+        for (size_t i = 0; i < kPixels; ++i) {
+            checksum += apply_gamma(hsv_to_rgb_fixed({in.hue[i], in.saturation[i], in.value[i]})).red;
+        }
+    }
+    const int64_t fixed_us = now_us() - start;
+
+    start = now_us();
+    for (int round = 0; round < kRounds; ++round) {
+        hsv_to_rgb_gamma(in.planes(), out.planes());
+        checksum += out.red[round];
+    }
+    const int64_t batch_us = now_us() - start;
+
+    constexpr size_t kConversions = kPixels * kRounds;
+    printf("hsv->rgb+gamma ns/pixel: float %lld, fixed %lld, batch %lld (checksum %lu)\n",
+           static_cast<long long>(float_us * 1000 / kConversions),
+           static_cast<long long>(fixed_us * 1000 / kConversions),
+           static_cast<long long>(batch_us * 1000 / kConversions), static_cast<unsigned long>(checksum));
+}
+
+static int run_tests()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_primaries_are_exact);
+    RUN_TEST(test_fixed_within_error_bound_of_float);
+    RUN_TEST(test_batch_matches_scalar_with_gamma);
+    RUN_TEST(test_batch_stops_at_shortest_plane);
+    RUN_TEST(test_benchmark_fixed_against_float);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    run_tests();
+}
+#else
+int main()
+{
+    return run_tests();
+}
+#endif
@@ -0,0 +1,105 @@
+#include <unity.h>
+
+#include "display_state.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+void setUp() {}
+void tearDown() {}
+
+constexpr uint32_t kDefaultFields = display_field_bit(DisplayField::MODE) |
+                                    display_field_bit(DisplayField::BACKLIGHT) |
+                                    display_field_bit(DisplayField::EFFECT);
+
+void test_defaults_are_dirty_until_first_take()
+{
+    DisplayState state;
+    DisplayStateData data{};
+    TEST_ASSERT_EQUAL_HEX32(kDefaultFields, state.take(data));
+    TEST_ASSERT_EQUAL(DisplayMode::CLOCK_HHMMSS, data.mode);
+    TEST_ASSERT_EQUAL_UINT8(255, data.backlight[0].brightness);
+    TEST_ASSERT_EQUAL_HEX32(0, state.take(data));
+}
+
+void test_burst_coalesces_to_latest_value()
+{
+    DisplayState state;
+    DisplayStateData data{};
+    state.take(data);
+
+    for (uint8_t s = 0; s < 20; ++s) {
+        state.set_time(12, 34, s);
+    }
+    TEST_ASSERT_EQUAL_HEX32(display_field_bit(DisplayField::TIME), state.take(data));
+    TEST_ASSERT_EQUAL_UINT8(19, data.time.s);
+    TEST_ASSERT_EQUAL_UINT32(20, data.versions[static_cast<size_t>(DisplayField::TIME)]);
+
+    const DisplayStateStats stats = state.stats();
+    TEST_ASSERT_EQUAL_UINT32(20, stats.writes);
+    TEST_ASSERT_EQUAL_UINT32(19, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.takes);
+}
+
+void test_show_number_sets_mode_and_number_together()
+{
+    DisplayState state;
+    DisplayStateData data{};
+    state.take(data);
+
+    state.show_number(123456);
+    TEST_ASSERT_EQUAL_HEX32(display_field_bit(DisplayField::MODE), state.take(data));
+    TEST_ASSERT_EQUAL(DisplayMode::MANUAL_DISPLAY, data.mode);
+    TEST_ASSERT_EQUAL_UINT32(123456, data.manual_number);
+}
+
+void test_backlight_sets_one_tube_or_all()
+{
+    DisplayState state;
+    DisplayStateData data{};
+    state.take(data);
+
+    const RgbColor green = {0, 255, 0};
+    const uint8_t dim = 40;
+    state.set_backlight(2, &green, nullptr);
+    state.set_backlight(-1, nullptr, &dim);
+    TEST_ASSERT_EQUAL_HEX32(display_field_bit(DisplayField::BACKLIGHT), state.take(data));
+    for (size_t tube = 0; tube < data.backlight.size(); ++tube) {
+        TEST_ASSERT_EQUAL_UINT16(tube == 2 ? 120 : 0, data.backlight[tube].color.hue);
+        TEST_ASSERT_EQUAL_UINT8(dim, data.backlight[tube].brightness);
+    }
+
+    // Out of range is refused, not clamped
+    state.set_backlight(static_cast<int>(kNixieTubeCount), &green, &dim);
+    TEST_ASSERT_EQUAL_HEX32(0, state.take(data));
+}
+
+void test_fields_written_before_take_are_all_reported()
+{
+    DisplayState state;
+    DisplayStateData data{};
+    state.take(data);
+
+    GasgaugeData battery = {};
+    battery.soc = 42;
+    state.set_battery(battery);
+    state.flash({255, 255, 255}, 3);
+    state.set_transition(1, 250);
+    TEST_ASSERT_EQUAL_HEX32(display_field_bit(DisplayField::BATTERY) | display_field_bit(DisplayField::FLASH) |
+                                display_field_bit(DisplayField::TRANSITION),
+                            state.take(data));
+    TEST_ASSERT_EQUAL_UINT8(42, data.battery.soc);
+    TEST_ASSERT_EQUAL_UINT8(3, data.flash.count);
+    TEST_ASSERT_EQUAL_UINT16(250, data.transition.duration_ms);
+}
+
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    UNITY_BEGIN();
+    RUN_TEST(test_defaults_are_dirty_until_first_take);
+    RUN_TEST(test_burst_coalesces_to_latest_value);
+    RUN_TEST(test_show_number_sets_mode_and_number_together);
+    RUN_TEST(test_backlight_sets_one_tube_or_all);
+    RUN_TEST(test_fields_written_before_take_are_all_reported);
+    UNITY_END();
+}
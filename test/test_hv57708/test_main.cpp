@@ -0,0 +1,114 @@
+#include <unity.h>
+
+#include "hv57708/hv57708_bitstream.h"
+#include "hv57708_digit_map.h"
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// Runs on the target and on the host (pio test -e native)
+
+void setUp() {}
+void tearDown() {}
+
+// Reads HVOUT(output + 1) back out of the quad-SPI bitstream: clock c
+// carries outputs 4 * (15 - c) .. +3, high nibble of each byte first.
+static bool output_in_frame(const Hv57708Bitstream::Frame &frame, size_t output)
+{
+    const size_t clock = Hv57708Bitstream::kClocksPerFrame - 1 - output / 4;
+    const size_t shift = ((clock % 2 == 0) ? 4 : 0) + output % 4;
+    return (frame[clock / 2] >> shift) & 0x01;
+}
+
+void test_encode_first_output_is_clocked_last()
+{
+    Hv57708Bitstream::Frame frame = Hv57708Bitstream::encode(1ULL << 0);
+    for (size_t i = 0; i < frame.size() - 1; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, frame[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x01, frame[7]);
+}
+
+void test_encode_last_output_is_clocked_first()
+{
+    Hv57708Bitstream::Frame frame = Hv57708Bitstream::encode(1ULL << 63);
+    TEST_ASSERT_EQUAL_HEX8(0x80, frame[0]);
+    for (size_t i = 1; i < frame.size(); ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, frame[i]);
+    }
+}
+
+void test_encode_nibbles_feed_all_four_inputs()
+{
+    // HVOUT1..4 share the last clock, one per data line
+    Hv57708Bitstream::Frame frame = Hv57708Bitstream::encode(0x0FULL);
+    TEST_ASSERT_EQUAL_HEX8(0x0F, frame[7]);
+    frame = Hv57708Bitstream::encode(0xF0ULL);
+    TEST_ASSERT_EQUAL_HEX8(0xF0, frame[7]);
+}
+
+void test_every_digit_lights_only_its_cathode()
+{
+    for (size_t tube = 0; tube < kNixieTubeCount; ++tube) {
+        for (uint8_t numeral = 0; numeral < 10; ++numeral) {
+            std::array<uint8_t, kNixieTubeCount> digits;
+            digits.fill(10);
+            digits[tube] = numeral;
+            Hv57708Bitstream::Frame frame = Hv57708Bitstream::encode(hv57708_digit_outputs(digits));
+            const size_t lit = kHv57708DigitMap[tube][numeral];
+            for (size_t output = 0; output < Hv57708Bitstream::kOutputCount; ++output) {
+                TEST_ASSERT_EQUAL(output == lit, output_in_frame(frame, output));
+            }
+        }
+    }
+}
+
+void test_time_frame_matches_digit_map()
+{
+    std::array<uint8_t, kNixieTubeCount> digits;
+    for (size_t tube = 0; tube < digits.size(); ++tube) {
+        digits[tube] = static_cast<uint8_t>((tube * 7 + 1) % 10);
+    }
+    Hv57708Bitstream::Frame frame = Hv57708Bitstream::encode(hv57708_digit_outputs(digits));
+    size_t lit_count = 0;
+    for (size_t output = 0; output < Hv57708Bitstream::kOutputCount; ++output) {
+        lit_count += output_in_frame(frame, output) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(kNixieTubeCount, lit_count);
+    for (size_t tube = 0; tube < digits.size(); ++tube) {
+        TEST_ASSERT_TRUE(output_in_frame(frame, kHv57708DigitMap[tube][digits[tube]]));
+    }
+}
+
+void test_blank_numeral_lights_nothing()
+{
+    std::array<uint8_t, kNixieTubeCount> digits;
+    digits.fill(10);
+    TEST_ASSERT_EQUAL_UINT64(0, hv57708_digit_outputs(digits));
+}
+
+static int run_tests()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_encode_first_output_is_clocked_last);
+    RUN_TEST(test_encode_last_output_is_clocked_first);
+    RUN_TEST(test_encode_nibbles_feed_all_four_inputs);
+    RUN_TEST(test_every_digit_lights_only_its_cathode);
+    RUN_TEST(test_time_frame_matches_digit_map);
+    RUN_TEST(test_blank_numeral_lights_nothing);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    run_tests();
+}
+#else
+int main()
+{
+    return run_tests();
+}
+#endif
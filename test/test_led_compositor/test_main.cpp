@@ -0,0 +1,197 @@
+#include <unity.h>
+
+#include "led_compositor.h"
+#include "led_effects.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Opaque single-colour layer that only changes when told to
+class TestEffect : public ILedEffect
+{
+public:
+    const char *name() const override { return "test"; }
+    bool advance(uint32_t dt_ms) override
+    {
+        (void)dt_ms;
+        const bool changed = changed_;
+        changed_ = false;
+        return changed;
+    }
+    void draw(LedLayerFrame &frame) override
+    {
+        frame.color.red.fill(level);
+        frame.color.green.fill(level);
+        frame.color.blue.fill(level);
+        frame.alpha.fill(alpha);
+        draws++;
+    }
+    void set(uint16_t new_level)
+    {
+        level = new_level;
+        changed_ = true;
+    }
+
+    uint16_t level = 0;
+    uint8_t alpha = 255;
+    int draws = 0;
+
+private:
+    bool changed_ = true;
+};
+
+void test_unchanged_frame_is_skipped()
+{
+    LedCompositor compositor;
+    TestEffect base;
+    compositor.add_layer(base, LedBlend::NORMAL);
+    base.set(200 << 8);
+
+    TEST_ASSERT_TRUE(compositor.render(20));
+    TEST_ASSERT_EQUAL_UINT16(200 << 8, compositor.output().red[0]);
+    TEST_ASSERT_FALSE(compositor.render(20));
+    TEST_ASSERT_FALSE(compositor.render(20));
+    TEST_ASSERT_EQUAL(1, base.draws);
+    TEST_ASSERT_EQUAL_UINT32(3, compositor.stats().frames);
+    TEST_ASSERT_EQUAL_UINT32(1, compositor.stats().composed);
+
+    base.set(100 << 8);
+    TEST_ASSERT_TRUE(compositor.render(20));
+    TEST_ASSERT_EQUAL_UINT16(100 << 8, compositor.output().blue[kBacklightLedCount - 1]);
+}
+
+void test_blend_modes()
+{
+    LedCompositor compositor;
+    TestEffect base;
+    TestEffect multiply;
+    TestEffect add;
+    base.set(200 << 8);
+    multiply.set(kColor16Max / 2);
+    add.set(100 << 8);
+    compositor.add_layer(base, LedBlend::NORMAL);
+    const int multiply_layer = compositor.add_layer(multiply, LedBlend::MULTIPLY);
+    const int add_layer = compositor.add_layer(add, LedBlend::ADD, false);
+
+    TEST_ASSERT_TRUE(compositor.render(20));
+    TEST_ASSERT_EQUAL_UINT16(100 << 8, compositor.output().red[0]);
+
+    compositor.set_enabled(add_layer, true);
+    TEST_ASSERT_TRUE(compositor.render(20));
+    TEST_ASSERT_EQUAL_UINT16(200 << 8, compositor.output().red[0]);
+
+    // Switching a layer off recomposites even though nothing else changed
+    compositor.set_enabled(multiply_layer, false);
+    TEST_ASSERT_TRUE(compositor.render(20));
+    TEST_ASSERT_EQUAL_UINT16(kColor16Max, compositor.output().red[0]);
+}
+
+void test_transparent_pixels_leave_layers_below()
+{
+    LedCompositor compositor;
+    TestEffect base;
+    TestEffect overlay;
+    base.set(50 << 8);
+    overlay.set(250 << 8);
+    overlay.alpha = 0;
+    compositor.add_layer(base, LedBlend::NORMAL);
+    compositor.add_layer(overlay, LedBlend::NORMAL);
+    TEST_ASSERT_TRUE(compositor.render(20));
+    TEST_ASSERT_EQUAL_UINT16(50 << 8, compositor.output().green[3]);
+}
+
+void test_battery_bar_shows_then_fades()
+{
+    BatteryBarEffect bar;
+    LedLayerFrame frame;
+    bar.set_level(50);
+    TEST_ASSERT_TRUE(bar.advance(20));
+    bar.draw(frame);
+    TEST_ASSERT_EQUAL_UINT8(255, frame.alpha[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, frame.alpha[kBacklightLedCount - 1]);
+
+    // Same level again does not re-show it
+    bar.set_level(50);
+    bool changed = false;
+    for (int i = 0; i < 200; ++i) {
+        if (bar.advance(20)) {
+            bar.draw(frame);
+            changed = true;
+        }
+    }
+    TEST_ASSERT_TRUE(changed);
+    TEST_ASSERT_EQUAL_UINT8(0, frame.alpha[0]);
+    TEST_ASSERT_FALSE(bar.advance(20));
+}
+
+void test_flash_goes_idle()
+{
+    FlashEffect flash;
+    LedLayerFrame frame;
+    flash.trigger({255, 255, 255}, 2);
+    uint8_t peak = 0;
+    for (int i = 0; i < 100; ++i) {
+        if (flash.advance(20)) {
+            flash.draw(frame);
+            peak = frame.alpha[0] > peak ? frame.alpha[0] : peak;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8(255, peak);
+    TEST_ASSERT_EQUAL_UINT8(0, frame.alpha[0]);
+    TEST_ASSERT_FALSE(flash.advance(20));
+}
+
+void test_solid_colours_each_tube_group()
+{
+    TubeBacklight tubes;
+    tubes.fill({{0, 0, 0}, 255});
+    tubes[1] = {{0, 255, 255}, 255};   // red
+    tubes[2] = {{120, 255, 255}, 128}; // green, dimmed
+    SolidColorEffect solid;
+    LedLayerFrame frame;
+    solid.set_colors(tubes);
+    TEST_ASSERT_TRUE(solid.advance(20));
+    solid.draw(frame);
+
+    for (size_t led = 0; led < kBacklightLedsPerTube; ++led) {
+        TEST_ASSERT_EQUAL_UINT16(0, frame.color.red[led]);
+        TEST_ASSERT_EQUAL_UINT16(kColor16Max, frame.color.red[kBacklightLedsPerTube + led]);
+        TEST_ASSERT_EQUAL_UINT16(0, frame.color.green[kBacklightLedsPerTube + led]);
+        TEST_ASSERT_EQUAL_UINT16(gamma16(128), frame.color.green[2 * kBacklightLedsPerTube + led]);
+    }
+    TEST_ASSERT_FALSE(solid.advance(20));
+}
+
+void test_rainbow_chase_offsets_each_tube()
+{
+    TubeBacklight tubes;
+    tubes.fill({{0, 255, 255}, 255});
+    RainbowEffect rainbow;
+    LedLayerFrame frame;
+    rainbow.set_colors(tubes);
+    rainbow.set_spread(120);
+    TEST_ASSERT_TRUE(rainbow.advance(0));
+    rainbow.draw(frame);
+
+    // Hues 0, 120, 240: red, green, blue on the first three tubes
+    TEST_ASSERT_EQUAL_UINT16(kColor16Max, frame.color.red[0]);
+    TEST_ASSERT_EQUAL_UINT16(kColor16Max, frame.color.green[kBacklightLedsPerTube]);
+    TEST_ASSERT_EQUAL_UINT16(kColor16Max, frame.color.blue[2 * kBacklightLedsPerTube]);
+    TEST_ASSERT_EQUAL_UINT16(0, frame.color.red[2 * kBacklightLedsPerTube]);
+}
+
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_frame_is_skipped);
+    RUN_TEST(test_blend_modes);
+    RUN_TEST(test_transparent_pixels_leave_layers_below);
+    RUN_TEST(test_battery_bar_shows_then_fades);
+    RUN_TEST(test_flash_goes_idle);
+    RUN_TEST(test_solid_colours_each_tube_group);
+    RUN_TEST(test_rainbow_chase_offsets_each_tube);
+    UNITY_END();
+}
@@ -0,0 +1,65 @@
+#include <unity.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nixie_tube.h"
+#include "pca9685/pca9685.h"
+
+void setUp() {}
+void tearDown() {}
+
+// The sequential scan gives each tube one PWM period per slot
+constexpr uint8_t kPrescale = Pca9685::prescale_for(1000.0f);
+constexpr uint32_t kSlotUs = Pca9685::period_us(kPrescale);
+
+// Microseconds a cathode glows in its slot at a given duty
+static uint32_t lit_us(uint16_t duty)
+{
+    return (static_cast<uint32_t>(duty) * kSlotUs) / 4096;
+}
+
+void test_slot_holds_exactly_one_pwm_period()
+{
+    TEST_ASSERT_EQUAL_UINT8(5, kPrescale);
+    TEST_ASSERT_EQUAL_UINT32(983, kSlotUs);
+    TEST_ASSERT_EQUAL_UINT8(kPrescale, Pca9685::prescale_for(1000000.0f / kSlotUs));
+}
+
+void test_duty_spans_full_range()
+{
+    TEST_ASSERT_EQUAL_UINT16(0, nixie_cathode_duty(0, 255));
+    TEST_ASSERT_EQUAL_UINT16(0, nixie_cathode_duty(255, 0));
+    TEST_ASSERT_EQUAL_UINT16(4095, nixie_cathode_duty(255, 255));
+    TEST_ASSERT_UINT32_WITHIN(2, kSlotUs / 2, lit_us(nixie_cathode_duty(255, 128)));
+}
+
+void test_calibrated_brightness_is_monotonic()
+{
+    for (uint32_t level = 0; level <= 255; ++level) {
+        uint32_t previous = 0;
+        for (uint32_t calibration = 0; calibration <= 255; ++calibration) {
+            const uint32_t on = lit_us(nixie_cathode_duty(static_cast<uint8_t>(level), static_cast<uint8_t>(calibration)));
+            TEST_ASSERT_TRUE(on >= previous);
+            TEST_ASSERT_TRUE(on <= kSlotUs);
+            previous = on;
+        }
+    }
+    for (uint32_t calibration = 0; calibration <= 255; ++calibration) {
+        uint16_t previous = 0;
+        for (uint32_t level = 0; level <= 255; ++level) {
+            const uint16_t duty = nixie_cathode_duty(static_cast<uint8_t>(level), static_cast<uint8_t>(calibration));
+            TEST_ASSERT_TRUE(duty >= previous);
+            previous = duty;
+        }
+    }
+}
+
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    UNITY_BEGIN();
+    RUN_TEST(test_slot_holds_exactly_one_pwm_period);
+    RUN_TEST(test_duty_spans_full_range);
+    RUN_TEST(test_calibrated_brightness_is_monotonic);
+    UNITY_END();
+}
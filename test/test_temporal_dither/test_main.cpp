@@ -0,0 +1,199 @@
+#include <unity.h>
+
+#include <cstdio>
+#include "color_model.h"
+#include "temporal_dither.h"
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#endif
+
+// Runs on the target and on the host (pio test -e native)
+
+void setUp() {}
+void tearDown() {}
+
+static int64_t now_us()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+static LedPixels uniform(uint16_t level)
+{
+    LedPixels pixels;
+    pixels.red.fill(level);
+    pixels.green.fill(level);
+    pixels.blue.fill(level);
+    return pixels;
+}
+
+// Sum of each red output over frames, so sum / frames is the shown level
+static std::array<uint32_t, kBacklightLedCount> red_sums(TemporalDither &dither, const LedPixels &target,
+                                                         int frames)
+{
+    std::array<uint32_t, kBacklightLedCount> sums{};
+    LedOutput out;
+    for (int frame = 0; frame < frames; ++frame) {
+        dither.apply(target, out);
+        for (size_t i = 0; i < sums.size(); ++i) {
+            sums[i] += out.red[i];
+        }
+    }
+    return sums;
+}
+
+void test_average_over_256_frames_is_exact()
+{
+    const uint16_t levels[] = {1, 0x0080, 0x00FF, 0x0F37, 0x7FFF, 0xFE01};
+    for (uint16_t level : levels) {
+        TemporalDither dither;
+        const auto sums = red_sums(dither, uniform(level), 256);
+        for (uint32_t sum : sums) {
+            // 256 frames of level / 256 each
+            TEST_ASSERT_EQUAL_UINT32(level, sum);
+        }
+    }
+}
+
+void test_average_over_short_window_is_close()
+{
+    LedPixels target;
+    for (size_t i = 0; i < kBacklightLedCount; ++i) {
+        target.red[i] = static_cast<uint16_t>(i * 977 + 13);
+    }
+    TemporalDither dither;
+    constexpr int kFrames = 100;
+    const auto sums = red_sums(dither, target, kFrames);
+    for (size_t i = 0; i < sums.size(); ++i) {
+        // Within one output step over the window, i.e. 1/100 LSB on average
+        TEST_ASSERT_INT_WITHIN(256, static_cast<int32_t>(target.red[i]) * kFrames,
+                               static_cast<int32_t>(sums[i] * 256));
+    }
+}
+
+void test_whole_levels_do_not_flicker()
+{
+    TemporalDither dither;
+    LedOutput out;
+    // Leftover error from a dithered frame must not leak into a whole one
+    dither.apply(uniform(0x1280), out);
+    for (int frame = 0; frame < 10; ++frame) {
+        TEST_ASSERT_FALSE(dither.apply(uniform(0x3200), out));
+        TEST_ASSERT_EQUAL_UINT8(0x32, out.red[0]);
+        TEST_ASSERT_EQUAL_UINT8(0x32, out.blue[kBacklightLedCount - 1]);
+    }
+    TEST_ASSERT_FALSE(dither.apply(uniform(kColor16Max), out));
+    TEST_ASSERT_EQUAL_UINT8(255, out.green[0]);
+    TEST_ASSERT_TRUE(dither.apply(uniform(0x0001), out));
+}
+
+void test_levels_below_gamma_floor_stay_distinct()
+{
+    // Input 1 is below even the 8.8 table's first step
+    TEST_ASSERT_EQUAL_UINT16(0, gamma16(1));
+
+    // Inputs 2-14 gamma-correct to 0 in 8 bits; dithered at full depth,
+    // each one shows brighter than the last
+    uint32_t previous = 0;
+    for (uint8_t level = 2; level < 15; ++level) {
+        TEST_ASSERT_EQUAL_UINT8(0, apply_gamma({level, level, level}).red);
+        TemporalDither dither;
+        const uint32_t sum = red_sums(dither, uniform(gamma16(level)), 256)[0];
+        TEST_ASSERT_EQUAL_UINT32(gamma16(level), sum);
+        TEST_ASSERT_TRUE(sum > previous);
+        previous = sum;
+    }
+}
+
+void test_depth_follows_frame_rate()
+{
+    TEST_ASSERT_EQUAL_UINT8(0, TemporalDither::depth_for_rate(40));
+    TEST_ASSERT_EQUAL_UINT8(1, TemporalDither::depth_for_rate(50));
+    TEST_ASSERT_EQUAL_UINT8(2, TemporalDither::depth_for_rate(100));
+    TEST_ASSERT_EQUAL_UINT8(3, TemporalDither::depth_for_rate(200));
+    TEST_ASSERT_EQUAL_UINT8(8, TemporalDither::depth_for_rate(6400));
+}
+
+void test_limited_depth_repeats_within_its_cycle()
+{
+    // At 50 Hz no pattern may be slower than two frames
+    const uint8_t depth = TemporalDither::depth_for_rate(50);
+    const uint16_t levels[] = {gamma16(2), gamma16(14), 0x0140, 0x3377, 0xFEF0};
+    for (uint16_t level : levels) {
+        TemporalDither dither(depth);
+        LedOutput out;
+        std::array<uint8_t, 8> shown{};
+        for (size_t frame = 0; frame < shown.size(); ++frame) {
+            dither.apply(uniform(level), out);
+            shown[frame] = out.red[0];
+        }
+        const uint32_t cycle = 1u << depth;
+        for (size_t frame = cycle; frame < shown.size(); ++frame) {
+            TEST_ASSERT_EQUAL_UINT8(shown[frame - cycle], shown[frame]);
+        }
+    }
+
+    // Too small a fraction for two frames to show rounds to off, not a
+    // flash every couple of seconds
+    TemporalDither dither(depth);
+    const auto sums = red_sums(dither, uniform(gamma16(2)), 256);
+    TEST_ASSERT_EQUAL_UINT32(0, sums[0]);
+}
+
+// Not an assertion, just the number: the cost of one strip-sized frame
+void test_benchmark_dither_frame()
+{
+    constexpr int kFrames = 1000;
+    LedPixels target;
+    for (size_t i = 0; i < kBacklightLedCount; ++i) {
+        target.red[i] = static_cast<uint16_t>(i * 1021);
+        target.green[i] = static_cast<uint16_t>(i * 331);
+        target.blue[i] = static_cast<uint16_t>(i * 97);
+    }
+    TemporalDither dither;
+    LedOutput out;
+    uint32_t checksum = 0;
+    const int64_t start = now_us();
+    for (int frame = 0; frame < kFrames; ++frame) {
+        dither.apply(target, out);
+        checksum += out.red[frame % kBacklightLedCount];
+    }
+    const int64_t elapsed_us = now_us() - start;
+    printf("dither %u LEDs: %lld ns/frame (checksum %lu)\n", static_cast<unsigned>(kBacklightLedCount),
+           static_cast<long long>(elapsed_us * 1000 / kFrames), static_cast<unsigned long>(checksum));
+}
+
+static int run_tests()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_average_over_256_frames_is_exact);
+    RUN_TEST(test_average_over_short_window_is_close);
+    RUN_TEST(test_whole_levels_do_not_flicker);
+    RUN_TEST(test_levels_below_gamma_floor_stay_distinct);
+    RUN_TEST(test_depth_follows_frame_rate);
+    RUN_TEST(test_limited_depth_repeats_within_its_cycle);
+    RUN_TEST(test_benchmark_dither_frame);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+extern "C" void app_main(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    run_tests();
+}
+#else
+int main()
+{
+    return run_tests();
+}
+#endif